@@ -0,0 +1,112 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lcd.h"
+#include "joy.h"
+#include "ball.h"
+#include "brick.h"
+#include "collide.h"
+#include "autoplay.h"
+
+#define SCREEN_WIDTH LCD_W
+
+#define LEG PHYS(1.0)     // Time cast per leg of the path in seconds
+#define GAIN 8            // Error in pixels for full joystick displacement
+#define AIM_MAX PHYS(0.4) // Largest bounce offset, fraction of the platform
+
+/************************ Prediction *************************/
+bool autoplay_predict(const ball_t *ball, const brick_grid_t *bricks,
+                      phys_t y, phys_t *x) {
+    if (!ball || !bricks || !x) return false;
+
+    brick_grid_t grid = *bricks; // Bricks hit are destroyed on the way
+    phys_t bx = ball->x, by = ball->y;
+    phys_t dx = ball->dx, dy = ball->dy;
+    phys_t r = ball->radius;
+
+    for (uint32_t i = 0; i <= AUTOPLAY_BOUNCES; i++) {
+        phys_t mx = phys_mul(dx, LEG), my = phys_mul(dy, LEG);
+
+        // Earliest contact
+        phys_t t = PHYS_MAX, nx = 0, ny = 0;
+        phys_t ht, hnx, hny;
+        int row = -1, col = 0, hrow, hcol;
+        if (collide_sweep_walls(bx, by, mx, my, r, &ht, &hnx, &hny) &&
+            ht < t) {
+            t = ht; nx = hnx; ny = hny;
+        }
+        if (bricks_sweep(&grid, bx, by, mx, my, r,
+                         &ht, &hrow, &hcol, &hnx, &hny) && ht < t) {
+            t = ht; nx = hnx; ny = hny; row = hrow; col = hcol;
+        }
+
+        // Reaches y before the contact
+        if (my > 0 && by + my >= y) {
+            phys_t ty = phys_div(y - by, my);
+            if (ty <= t) {
+                *x = bx + phys_mul(mx, ty);
+                return true;
+            }
+        }
+        if (t > PHYS_ONE) { // No contact on this leg
+            bx += mx;
+            by += my;
+            continue;
+        }
+
+        // Move to the contact and bounce
+        bx += phys_mul(mx, t);
+        by += phys_mul(my, t);
+        ball_reflect(&dx, &dy, nx, ny);
+        if (row >= 0) bricks_hit(&grid, row, col);
+    }
+    return false;
+}
+
+/************************ Steering *************************/
+// Get the x center of the lowest alive brick. Return false if none.
+static bool brick_target(const brick_grid_t *bricks, phys_t *x) {
+    brick_iter_t it = bricks_iter(bricks);
+    int row, col, lrow = -1, lcol = 0;
+    while (bricks_next(&it, &row, &col)) {
+        lrow = row;
+        lcol = col;
+    }
+    if (lrow < 0) return false;
+
+    phys_t bx, by, bw, bh;
+    bricks_get_box(bricks, lrow, lcol, &bx, &by, &bw, &bh);
+    *x = bx + bw/2;
+    return true;
+}
+
+void autoplay_steer(input_t *in, const ball_t *ball, const platform_t *p,
+                    const brick_grid_t *bricks) {
+    if (!in || !ball || !p || !bricks) return;
+
+    // Launch a waiting ball
+    in->buttons |= INPUT_A;
+
+    // Where the platform center should go: under the ball where it will
+    // come down, offset so the bounce heads for the bricks. The bounce
+    // angle follows where the ball hits the platform.
+    phys_t cx = p->x + p->width/2;
+    phys_t goal = ball->x;
+    phys_t hit;
+    if (ball->dy > 0 &&
+        autoplay_predict(ball, bricks, p->y - ball->radius, &hit)) {
+        goal = hit;
+        phys_t tx;
+        if (brick_target(bricks, &tx)) {
+            phys_t aim = phys_clamp(phys_div(tx - hit, phys_from_int(SCREEN_WIDTH)),
+                                    -AIM_MAX, AIM_MAX);
+            goal -= phys_mul(aim, p->width);
+        }
+    }
+
+    int32_t d = phys_floor(goal - cx) * (JOY_MAX_DISP/GAIN);
+    if (d > JOY_MAX_DISP) d = JOY_MAX_DISP;
+    if (d < -JOY_MAX_DISP) d = -JOY_MAX_DISP;
+    in->joy_x = d;
+    in->joy_y = 0;
+}
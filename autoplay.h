@@ -0,0 +1,34 @@
+#ifndef AUTOPLAY_H
+#define AUTOPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "phys.h"
+#include "ball.h"
+#include "platform.h"
+#include "brick.h"
+#include "input.h"
+
+// Bot that plays the game for soak and load tests. It predicts where the
+// ball will reach the platform by ray casting its path, bouncing off the
+// walls and the bricks on the way (bricks hit lose hit points as in the
+// game), and steers the platform there with the joystick displacement,
+// just as a player would. It aims the bounce at the remaining bricks.
+// See input_set_bot() to use it in place of the live input.
+
+#define AUTOPLAY_BOUNCES 16 // Most bounces followed by a prediction
+
+/************************ Function Prototypes *************************/
+
+// Predict where the ball center will next come down to height y.
+// *x: predicted x position.
+// Return true if found within AUTOPLAY_BOUNCES bounces.
+bool autoplay_predict(const ball_t *ball, const brick_grid_t *bricks,
+                      phys_t y, phys_t *x);
+
+// Set the joystick displacement and buttons of the next step's input to
+// play the game.
+void autoplay_steer(input_t *in, const ball_t *ball, const platform_t *p,
+                    const brick_grid_t *bricks);
+
+#endif // AUTOPLAY_H
@@ -1,17 +1,12 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
-#include <math.h>
 
 #include "hw.h"
 #include "lcd.h"
 #include "ball.h"
+#include "render.h"
 #include "config.h"
-#include "sound.h"
-
-// Sound headers
-#include "userSound.h"     // bounce sound
-#include "missileLaunch.h" // lost sound
 
 #define SCREEN_WIDTH LCD_W
 #define SCREEN_HEIGHT LCD_H
@@ -28,17 +23,17 @@ enum ball_st_t {
 };
 
 // Global speed multiplier
-static float speed_multiplier = 1.0f;
+static phys_t speed_multiplier = PHYS_ONE;
 
 /************************ Initialization *************************/
 void ball_init(ball_t *ball) {
     if (!ball) return;
 
-    ball->x = SCREEN_WIDTH / 2;
-    ball->y = SCREEN_HEIGHT - 20;
-    ball->dx = SPEED;          // horizontal speed
-    ball->dy = -SPEED;         // vertical speed
-    ball->radius = RADIUS;
+    ball->x = phys_from_int(SCREEN_WIDTH / 2);
+    ball->y = phys_from_int(SCREEN_HEIGHT - 20);
+    ball->dx = phys_from_int(SPEED);   // horizontal speed
+    ball->dy = phys_from_int(-SPEED);  // vertical speed
+    ball->radius = phys_from_int(RADIUS);
     ball->color = WHITE;
     ball->currentState = init_st;
     ball->launch = false;
@@ -53,10 +48,10 @@ void ball_launch(ball_t *ball) {
 
 void ball_reset(ball_t *ball) {
     if (!ball) return;
-    ball->x = SCREEN_WIDTH / 2;
-    ball->y = SCREEN_HEIGHT - 20;
-    ball->dx = SPEED;
-    ball->dy = -SPEED;
+    ball->x = phys_from_int(SCREEN_WIDTH / 2);
+    ball->y = phys_from_int(SCREEN_HEIGHT - 20);
+    ball->dx = phys_from_int(SPEED);
+    ball->dy = phys_from_int(-SPEED);
     ball->currentState = idle_st;
     ball->launch = false;
 }
@@ -64,16 +59,25 @@ void ball_reset(ball_t *ball) {
 void ball_next_round(ball_t *ball) {
     if (!ball) return;
     ball_init(ball);
-    speed_multiplier *= 1.2f;   // increase speed by 20% each round
-    if (speed_multiplier > 2.0f)
-        speed_multiplier = 2.0f;
+    // increase speed by 20% each round
+    speed_multiplier = phys_mul(speed_multiplier, PHYS(1.2));
+    if (speed_multiplier > PHYS(2.0))
+        speed_multiplier = PHYS(2.0);
+}
+
+void ball_first_round(void) {
+    speed_multiplier = PHYS_ONE;
+}
+
+void ball_set_speed(phys_t speed) {
+    speed_multiplier = speed;
 }
 
 /************************ Status Functions *************************/
 void ball_get_pos(ball_t *ball, coord_t *x, coord_t *y) {
     if (!ball || !x || !y) return;
-    *x = (coord_t)ball->x;
-    *y = (coord_t)ball->y;
+    *x = phys_floor(ball->x);
+    *y = phys_floor(ball->y);
 }
 
 bool ball_is_moving(ball_t *ball) {
@@ -85,123 +89,60 @@ bool ball_is_lost(ball_t *ball) {
 }
 
 /************************ Collision Functions *************************/
-void ball_check_wall_collision(ball_t *ball) {
-    if (!ball) return;
-
-    bool bounced = false;
-
-    if (ball->x - ball->radius <= 0) {
-        ball->x = ball->radius;
-        ball->dx *= -1;
-        bounced = true;
-    }
-    if (ball->x + ball->radius >= SCREEN_WIDTH) {
-        ball->x = SCREEN_WIDTH - ball->radius;
-        ball->dx *= -1;
-        bounced = true;
-    }
-    if (ball->y - ball->radius <= 0) {
-        ball->y = ball->radius;
-        ball->dy *= -1;
-        bounced = true;
-    }
-
-    if (bounced)
-        sound_start(userSound, USERSOUND_SAMPLES, false);
+phys_t ball_get_speed(void) {
+    return speed_multiplier;
 }
 
-void ball_check_platform_collision(ball_t *ball,
-                                   float px, float py,
-                                   float pw, float ph) {
-    if (!ball) return;
-
-    if (ball->x + ball->radius >= px &&
-        ball->x - ball->radius <= px + pw &&
-        ball->y + ball->radius >= py &&
-        ball->y - ball->radius <= py + ph &&
-        ball->dy > 0)
-    {
-        ball->y = py - ball->radius;
-        ball->dy *= -1;
-
-        float hit_pos = (ball->x - px) / pw;
-        float angle = (hit_pos - 0.5f) * 2.0f;
-        ball->dx = angle * 200.0f;
-        if (ball->dy > -100.0f)
-            ball->dy = -100.0f;
-
-        sound_start(userSound, USERSOUND_SAMPLES, false);
-    }
+void ball_reflect(phys_t *dx, phys_t *dy, phys_t nx, phys_t ny) {
+    phys_t d = phys_mul(*dx, nx) + phys_mul(*dy, ny);
+    if (d >= 0) return; // Already moving away
+    *dx -= 2 * phys_mul(d, nx);
+    *dy -= 2 * phys_mul(d, ny);
 }
 
-bool ball_check_brick_collision(ball_t *ball,
-                                float bx, float by,
-                                float bw, float bh) {
-    if (!ball) return false;
-
-    float closestX = fmaxf(bx, fminf(ball->x, bx + bw));
-    float closestY = fmaxf(by, fminf(ball->y, by + bh));
+void ball_reflect_platform(phys_t x, phys_t *dx, phys_t *dy,
+                           phys_t px, phys_t pw) {
+    *dy = -*dy;
 
-    float dx = ball->x - closestX;
-    float dy = ball->y - closestY;
-
-    const float epsilon = 0.01f;
-    if ((dx*dx + dy*dy) <= (ball->radius * ball->radius + epsilon)) {
-
-        float brick_center_x = bx + bw/2;
-        float brick_center_y = by + bh/2;
-        float diff_x = ball->x - brick_center_x;
-        float diff_y = ball->y - brick_center_y;
-
-        if (fabsf(diff_x) > fabsf(diff_y))
-            ball->dx *= -1;
-        else
-            ball->dy *= -1;
-
-        return true;  // collision detected
-    }
-
-    return false;
+    phys_t hit_pos = phys_clamp(phys_div(x - px, pw), 0, PHYS_ONE);
+    phys_t angle = (hit_pos - PHYS(0.5)) * 2;
+    *dx = phys_mul(angle, PHYS(200.0));
+    if (*dy > PHYS(-100.0))
+        *dy = PHYS(-100.0);
 }
 
-
-
 /************************ Tick Function *************************/
 void ball_tick(ball_t *ball) {
     if (!ball) return;
 
-    float dt = CONFIG_GAME_TIMER_PERIOD;
-
     switch (ball->currentState) {
         case init_st:  ball->currentState = idle_st; break;
         case idle_st:  if (ball->launch) ball->currentState = moving_st; break;
         case moving_st:
-            ball->x += ball->dx * dt * speed_multiplier;
-            ball->y += ball->dy * dt * speed_multiplier;
-
-            ball_check_wall_collision(ball);
-            // Make sure you check platform collision somewhere in main loop
-
-            if (ball->y - ball->radius > SCREEN_HEIGHT) {
+            // Moved by collide_move_ball()
+            if (ball->y - ball->radius > phys_from_int(SCREEN_HEIGHT)) {
                 ball->currentState = lost_st;
-                sound_start(missileLaunch, MISSILELAUNCH_SAMPLES, false);
             }
             break;
         case lost_st: break;
     }
+}
+
+void ball_draw(ball_t *ball) {
+    if (!ball) return;
+
+    coord_t x = phys_floor(ball->x);
+    coord_t y = phys_floor(ball->y);
+    coord_t r = phys_floor(ball->radius);
 
-    // Draw ball
     switch (ball->currentState) {
         case init_st: break;
         case idle_st:
         case moving_st:
-            lcd_fillCircle((coord_t)ball->x, (coord_t)ball->y,
-                          (coord_t)ball->radius, ball->color);
-            break;
-        case lost_st:
-            lcd_fillCircle((coord_t)ball->x, (coord_t)ball->y,
-                          (coord_t)ball->radius, CONFIG_COLOR_BACKGROUND);
+            lcd_fillCircle(x, y, r, ball->color);
+            render_add(x-r, y-r, 2*r+1, 2*r+1);
             break;
+        case lost_st: break; // Erased by the render registry
     }
 }
 
@@ -4,14 +4,15 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "lcd.h"
+#include "phys.h"
 
 // Ball structure
 typedef struct {
-    float x;              // x position
-    float y;              // y position
-    float dx;             // x velocity
-    float dy;             // y velocity
-    float radius;         // ball radius
+    phys_t x;             // x position
+    phys_t y;             // y position
+    phys_t dx;            // x velocity
+    phys_t dy;            // y velocity
+    phys_t radius;        // ball radius
     color_t color;        // ball color
     uint8_t currentState; // internal state machine state
     bool launch;          // flag to launch ball
@@ -31,6 +32,12 @@ void ball_reset(ball_t *ball);
 // Move to next round with increased speed
 void ball_next_round(ball_t *ball);
 
+// Go back to the speed of the first round
+void ball_first_round(void);
+
+// Set the speed multiplier (e.g. from a saved game, see ball_get_speed())
+void ball_set_speed(phys_t speed);
+
 /************************ Status Functions *************************/
 // Get ball position
 void ball_get_pos(ball_t *ball, coord_t *x, coord_t *y);
@@ -42,22 +49,27 @@ bool ball_is_moving(ball_t *ball);
 bool ball_is_lost(ball_t *ball);
 
 /************************ Collision Functions *************************/
-// Check and handle wall collisions
-void ball_check_wall_collision(ball_t *ball);
+// These work on a velocity so they apply to ball_t and to ball sets.
 
-// Check and handle platform collision
-void ball_check_platform_collision(ball_t *ball,
-                                   float px, float py,
-                                   float pw, float ph);
+// Get the speed multiplier of the current round. Velocities are scaled
+// by it when moving.
+phys_t ball_get_speed(void);
 
-// Check and handle brick collision
-// Returns true if collision occurred
-bool ball_check_brick_collision(ball_t *ball,
-                                float bx, float by,
-                                float bw, float bh);
+// Reflect a velocity off a surface with unit normal (nx, ny)
+void ball_reflect(phys_t *dx, phys_t *dy, phys_t nx, phys_t ny);
+
+// Bounce a velocity off the top of the platform. The angle depends on
+// where the ball at x hits the platform at px of width pw.
+void ball_reflect_platform(phys_t x, phys_t *dx, phys_t *dy,
+                           phys_t px, phys_t pw);
 
 /************************ Tick Function *************************/
-// Update ball state machine (call every frame)
+// Update ball state machine (call every physics step).
+// A moving ball is moved by collide_move_ball() (see collide.h).
 void ball_tick(ball_t *ball);
 
+// Draw the ball at its current position (call every frame).
+// The drawn box is recorded with the render registry.
+void ball_draw(ball_t *ball);
+
 #endif // BALL_H
\ No newline at end of file
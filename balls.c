@@ -0,0 +1,103 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lcd.h"
+#include "balls.h"
+#include "render.h"
+
+#define SCREEN_HEIGHT LCD_H
+
+// Index of the lowest set bit (bits != 0)
+#define CTZ(bits) __builtin_ctz(bits)
+
+/************************ Initialization *************************/
+void balls_init(ball_set_t *set, phys_t radius, color_t color) {
+    if (!set) return;
+
+    for (int32_t w = 0; w < BALLS_WORDS; w++)
+        set->active[w] = 0;
+    set->count = 0;
+    set->radius = radius;
+    set->color = color;
+}
+
+/************************ Control Functions *************************/
+int32_t balls_add(ball_set_t *set, phys_t x, phys_t y, phys_t dx, phys_t dy) {
+    if (!set) return -1;
+
+    for (int32_t w = 0; w < BALLS_WORDS; w++) {
+        uint32_t free = ~set->active[w];
+        if (!free) continue;
+        int32_t i = w*32 + CTZ(free);
+        if (i >= CONFIG_MAX_BALLS) break;
+        set->x[i] = x;
+        set->y[i] = y;
+        set->dx[i] = dx;
+        set->dy[i] = dy;
+        set->active[w] |= 1u << (i & 31);
+        set->count++;
+        return i;
+    }
+    return -1;
+}
+
+void balls_remove(ball_set_t *set, int32_t i) {
+    if (!set || i < 0 || i >= CONFIG_MAX_BALLS) return;
+
+    uint32_t bit = 1u << (i & 31);
+    if (!(set->active[i >> 5] & bit)) return;
+    set->active[i >> 5] &= ~bit;
+    set->count--;
+}
+
+/************************ Iteration *************************/
+int32_t balls_first(const ball_set_t *set) {
+    return balls_next(set, -1);
+}
+
+int32_t balls_next(const ball_set_t *set, int32_t i) {
+    if (!set) return -1;
+
+    i++;
+    for (int32_t w = i >> 5; w < BALLS_WORDS; w++) {
+        uint32_t bits = set->active[w];
+        if (w == i >> 5) bits &= ~0u << (i & 31);
+        if (bits) return w*32 + CTZ(bits);
+    }
+    return -1;
+}
+
+/************************ Tick Function *************************/
+uint32_t balls_tick(ball_set_t *set) {
+    if (!set || !set->count) return 0;
+
+    uint32_t lost = 0;
+    phys_t bottom = phys_from_int(SCREEN_HEIGHT) + set->radius;
+    for (int32_t w = 0; w < BALLS_WORDS; w++) {
+        for (uint32_t bits = set->active[w]; bits; bits &= bits - 1) {
+            int32_t i = w*32 + CTZ(bits);
+            if (set->y[i] > bottom) {
+                set->active[w] &= ~(1u << (i & 31));
+                lost++;
+            }
+        }
+    }
+    set->count -= lost;
+    return lost;
+}
+
+/************************ Draw Function *************************/
+void balls_draw(const ball_set_t *set) {
+    if (!set || !set->count) return;
+
+    coord_t r = phys_floor(set->radius);
+    for (int32_t w = 0; w < BALLS_WORDS; w++) {
+        for (uint32_t bits = set->active[w]; bits; bits &= bits - 1) {
+            int32_t i = w*32 + CTZ(bits);
+            coord_t x = phys_floor(set->x[i]);
+            coord_t y = phys_floor(set->y[i]);
+            lcd_fillCircle(x, y, r, set->color);
+            render_add(x-r, y-r, 2*r+1, 2*r+1);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef BALLS_H
+#define BALLS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lcd.h"
+#include "phys.h"
+#include "config.h"
+
+// Set of extra balls (multi-ball and stress mode). The balls are stored
+// as a structure of arrays with a fixed capacity, so updates run in tight
+// loops over each field. A bit mask marks the slots in play. The balls
+// are moved by collide_move_balls() (see collide.h).
+
+#define BALLS_WORDS ((CONFIG_MAX_BALLS + 31) / 32)
+
+typedef struct {
+    phys_t x[CONFIG_MAX_BALLS];   // x positions
+    phys_t y[CONFIG_MAX_BALLS];   // y positions
+    phys_t dx[CONFIG_MAX_BALLS];  // x velocities
+    phys_t dy[CONFIG_MAX_BALLS];  // y velocities
+    uint32_t active[BALLS_WORDS]; // Bit i set if slot i is in play
+    uint16_t count;               // Number of balls in play
+    phys_t radius;                // Radius of every ball
+    color_t color;                // Color of every ball
+} ball_set_t;
+
+// Iterate over the slots in play: for (i = balls_first(s); i >= 0;
+// i = balls_next(s, i)).
+
+/************************ Function Prototypes *************************/
+
+// Initialize an empty ball set
+void balls_init(ball_set_t *set, phys_t radius, color_t color);
+
+// Add a ball.
+// Return the slot, or -1 if the set is full.
+int32_t balls_add(ball_set_t *set, phys_t x, phys_t y, phys_t dx, phys_t dy);
+
+// Remove the ball in a slot
+void balls_remove(ball_set_t *set, int32_t i);
+
+// Get the first slot in play, or -1 if none
+int32_t balls_first(const ball_set_t *set);
+
+// Get the next slot in play after slot i, or -1 if none
+int32_t balls_next(const ball_set_t *set, int32_t i);
+
+// Remove the balls that fell off the bottom (call every physics step).
+// Return the number of balls removed.
+uint32_t balls_tick(ball_set_t *set);
+
+// Draw the balls in play (call every frame).
+// The drawn boxes are recorded with the render registry.
+void balls_draw(const ball_set_t *set);
+
+#endif // BALLS_H
@@ -1,173 +1,248 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
-#include <math.h>
 
 #include "hw.h"
 #include "lcd.h"
 #include "brick.h"
+#include "render.h"
+#include "collide.h"
 #include "config.h"
-#include "ball.h"        // Needed so we can bounce the ball
-#include "userSound.h" 
-#include "sound.h"
 
 #define SCREEN_WIDTH LCD_W
 #define SCREEN_HEIGHT LCD_H
 
-// Brick internal states
-enum brick_st_t {
-    init_st,
-    alive_st,
-    dead_st
+// Column mask of a brick
+#define BIT(c) ((brick_mask_t)1 << (c))
+// Index of the lowest set bit (bits != 0)
+#define CTZ(bits) __builtin_ctzll((unsigned long long)(bits))
+
+// Brick colors by palette index (BRICK_CELL_COLOR). The letters of level
+// files follow the same order, see LEVEL_COLOR_CODES in level.h.
+static const color_t palette[16] = {
+    BLACK, RED, WHITE, BLUE, GREEN, YELLOW, CYAN, MAGENTA, GRAY,
+    rgb565(255, 128, 0), // Orange
 };
 
-/************************ Single Brick Functions *************************/
-static void brick_init_single(brick_t *b, float x, float y, float w, float h, color_t color) {
-    if (!b) return;
-    
-    b->x = x;
-    b->y = y;
-    b->width = w;
-    b->height = h;
-    b->color = color;
-    b->currentState = init_st;
-    b->destroy_me = false;
+// Lightening toward white per extra hit point, and at most (of 256)
+#define HP_SHADE 64
+#define HP_SHADE_MAX 192
+
+// Default colors of the rows (palette index)
+static const uint8_t row_colors[] = {1, 2, 3, 1, 2};
+#define ROW_COLORS (sizeof(row_colors) / sizeof(row_colors[0]))
+
+// Mask of columns 0 to n-1
+static brick_mask_t low_mask(int n) {
+    if (n >= (int)(8*sizeof(brick_mask_t))) return (brick_mask_t)~0;
+    return BIT(n) - 1;
 }
 
-static void brick_tick_single(brick_t *b) {
-    if (!b) return;
-    
-    // ---------- State Transitions ----------
-    switch (b->currentState) {
-        case init_st:
-            b->currentState = alive_st;
-            break;
-            
-        case alive_st:
-            if (b->destroy_me)
-                b->currentState = dead_st;
-            break;
-            
-        case dead_st:
-            // Stay dead
-            break;
+// Blend a color toward white by a/256
+static color_t lighten(color_t c, uint32_t a) {
+    uint32_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+    r += ((0x1F - r) * a) >> 8;
+    g += ((0x3F - g) * a) >> 8;
+    b += ((0x1F - b) * a) >> 8;
+    return (color_t)((r << 11) | (g << 5) | b);
+}
+
+// Bricks of a row overlapped by an erase (see render_stale())
+static brick_mask_t stale_row(int r) {
+    brick_mask_t m = 0;
+    for (int c = 0; c < MAX_BRICK_COLS; c += 32) {
+        int n = MAX_BRICK_COLS - c < 32 ? MAX_BRICK_COLS - c : 32;
+        m |= (brick_mask_t)render_stale(r*MAX_BRICK_COLS + c, n) << c;
     }
+    return m;
+}
+
+/************************ Single Brick Functions *************************/
+// Bricks are retained render objects: drawn when they change or were
+// overlapped by an erase, and erased once when they die.
+static void brick_draw_single(const brick_grid_t *grid, int r, int c, bool alive) {
+    uint32_t id = r*MAX_BRICK_COLS + c;
     
-    // ---------- State Actions ----------
-    switch (b->currentState) {
-        case init_st:
-            break;
-            
-        case alive_st:
-            lcd_fillRect((coord_t)b->x, (coord_t)b->y,
-                         (coord_t)b->width, (coord_t)b->height,
-                         b->color);
-            break;
-            
-        case dead_st:
-            // Erase brick (only once)
-            static bool erased = false;
-            if (!erased) {
-                lcd_fillRect((coord_t)b->x, (coord_t)b->y,
-                             (coord_t)b->width, (coord_t)b->height,
-                             CONFIG_COLOR_BACKGROUND);
-                erased = true;
-            }
-            break;
+    if (!alive) {
+        render_drop(id);
+        return;
     }
+    
+    phys_t fx, fy, fw, fh;
+    bricks_get_box(grid, r, c, &fx, &fy, &fw, &fh);
+    coord_t x = phys_floor(fx), y = phys_floor(fy);
+    coord_t w = phys_floor(fw), h = phys_floor(fh);
+    color_t color = bricks_get_color(grid, r, c);
+    
+    if (render_keep(id, x, y, w, h, color))
+        lcd_fillRect(x, y, w, h, color);
 }
 
 /************************ Brick Grid Functions *************************/
 void bricks_init(brick_grid_t *grid) {
+    bricks_init_layout(grid, 4, 10, 6, 6, phys_from_int(20));
+}
+
+void bricks_init_layout(brick_grid_t *grid, int rows, int cols,
+                        int spacing_x, int spacing_y, phys_t brick_h) {
     if (!grid) return;
     
-    grid->rows = 4;
-    grid->cols = 10;
-    grid->spacing_x = 6;
-    grid->spacing_y = 6;
-
-    float brick_width = 
-        (SCREEN_WIDTH - (grid->cols + 1) * grid->spacing_x) / (float)grid->cols;
-    float brick_height = 20;
-
-    for (int r = 0; r < grid->rows; r++) {
-        for (int c = 0; c < grid->cols; c++) {
-            brick_t *b = &grid->bricks[r][c];
-            
-            float x = grid->spacing_x + c * (brick_width + grid->spacing_x);
-            float y = grid->spacing_y + r * (brick_height + grid->spacing_y);
-            
-            color_t color;
-            switch (r) {
-                case 0: color = RED; break;
-                case 1: color = WHITE; break;
-                case 2: color = BLUE; break;
-                case 3: color = RED; break;
-                case 4: color = WHITE; break;
-                default: color = WHITE; break;
-            }
-            
-            brick_init_single(b, x, y, brick_width, brick_height, color);
-        }
+    grid->rows = rows < MAX_BRICK_ROWS ? rows : MAX_BRICK_ROWS;
+    grid->cols = cols < MAX_BRICK_COLS ? cols : MAX_BRICK_COLS;
+    grid->spacing_x = spacing_x;
+    grid->spacing_y = spacing_y;
+    grid->brick_w =
+        phys_from_int(SCREEN_WIDTH - (grid->cols + 1) * grid->spacing_x) / grid->cols;
+    grid->brick_h = brick_h;
+    bricks_touch(grid);
+
+    brick_mask_t all = low_mask(grid->cols);
+    for (int r = 0; r < MAX_BRICK_ROWS; r++) {
+        grid->alive[r] = r < grid->rows ? all : 0;
+        uint8_t color = r < (int)ROW_COLORS ? row_colors[r] : row_colors[ROW_COLORS-1];
+        for (int c = 0; c < grid->cols; c++)
+            grid->cell[r][c] = BRICK_CELL(color, 1);
     }
+    grid->alive_count = grid->rows * grid->cols;
 }
 
-void bricks_tick(brick_grid_t *grid) {
+void bricks_set_cell(brick_grid_t *grid, int row, int col, uint8_t cell) {
+    if (!grid || row < 0 || row >= grid->rows || col < 0 || col >= grid->cols)
+        return;
+
+    bool alive = grid->alive[row] & BIT(col);
+    if (BRICK_CELL_COLOR(cell)) {
+        if (!BRICK_CELL_HP(cell)) cell |= BRICK_CELL(0, 1);
+        if (!alive) grid->alive_count++;
+        grid->alive[row] |= BIT(col);
+    } else {
+        if (alive) grid->alive_count--;
+        grid->alive[row] &= ~BIT(col);
+    }
+    grid->cell[row][col] = cell;
+    grid->dirty[row] |= BIT(col);
+}
+
+void bricks_draw(const brick_grid_t *grid) {
     if (!grid) return;
     
-    for (int r = 0; r < grid->rows; r++)
-        for (int c = 0; c < grid->cols; c++)
-            brick_tick_single(&grid->bricks[r][c]);
+    // Every row, as a smaller layout leaves dirty cells past its rows
+    for (int r = 0; r < MAX_BRICK_ROWS; r++) {
+        brick_mask_t alive = grid->alive[r];
+        brick_mask_t stale = stale_row(r) & alive;
+        for (brick_mask_t bits = grid->dirty[r] | stale; bits; bits &= bits - 1) {
+            int c = CTZ(bits);
+            brick_draw_single(grid, r, c, alive & BIT(c));
+        }
+    }
 }
 
-/************************ Collision Detection With Bounce *************************/
-bool bricks_check_collision(brick_grid_t *grid,
-                            float ball_x, float ball_y, float ball_radius)
-{
-    if (!grid) return false;
+void bricks_clean(brick_grid_t *grid) {
+    if (!grid) return;
 
-    extern ball_t game_ball;   // Access the real ball to change dx/dy
+    for (int r = 0; r < MAX_BRICK_ROWS; r++)
+        grid->dirty[r] = 0;
+}
 
-    for (int r = 0; r < grid->rows; r++) {
-        for (int c = 0; c < grid->cols; c++) {
+void bricks_touch(brick_grid_t *grid) {
+    if (!grid) return;
 
-            brick_t *b = &grid->bricks[r][c];
+    for (int r = 0; r < MAX_BRICK_ROWS; r++)
+        grid->dirty[r] = low_mask(MAX_BRICK_COLS);
+}
 
-            // Skip dead or not fully alive yet
-            if (b->currentState != alive_st) 
-                continue;
+void bricks_copy(brick_grid_t *grid, const brick_grid_t *src) {
+    if (!grid || !src || grid == src) return;
 
-            // ------- AABB-circle collision -------
-            float closestX = ball_x;
-            if (ball_x < b->x) closestX = b->x;
-            else if (ball_x > b->x + b->width) closestX = b->x + b->width;
+    if (grid->rows != src->rows || grid->cols != src->cols ||
+        grid->spacing_x != src->spacing_x || grid->spacing_y != src->spacing_y ||
+        grid->brick_h != src->brick_h) {
+        *grid = *src;
+        bricks_touch(grid);
+        return;
+    }
+    brick_mask_t dirty[MAX_BRICK_ROWS];
+    for (int r = 0; r < MAX_BRICK_ROWS; r++) {
+        dirty[r] = grid->dirty[r] | src->dirty[r] | (grid->alive[r] ^ src->alive[r]);
+        for (int c = 0; c < grid->cols; c++)
+            if (grid->cell[r][c] != src->cell[r][c]) dirty[r] |= BIT(c);
+    }
+    *grid = *src;
+    for (int r = 0; r < MAX_BRICK_ROWS; r++)
+        grid->dirty[r] = dirty[r];
+}
 
-            float closestY = ball_y;
-            if (ball_y < b->y) closestY = b->y;
-            else if (ball_y > b->y + b->height) closestY = b->y + b->height;
+void bricks_merge_dirty(brick_grid_t *grid, const brick_grid_t *older) {
+    if (!grid || !older) return;
 
-            float dx = ball_x - closestX;
-            float dy = ball_y - closestY;
+    for (int r = 0; r < MAX_BRICK_ROWS; r++)
+        grid->dirty[r] |= older->dirty[r];
+}
 
-            if ((dx*dx + dy*dy) <= (ball_radius * ball_radius)) {
+void bricks_get_box(const brick_grid_t *grid, int row, int col,
+                    phys_t *x, phys_t *y, phys_t *w, phys_t *h) {
+    phys_t sx = phys_from_int(grid->spacing_x), sy = phys_from_int(grid->spacing_y);
+    *x = sx + col * (grid->brick_w + sx);
+    *y = sy + row * (grid->brick_h + sy);
+    *w = grid->brick_w;
+    *h = grid->brick_h;
+}
 
-                // ------- Bounce Logic -------
-                float brick_center_x = b->x + b->width / 2.0f;
-                float brick_center_y = b->y + b->height / 2.0f;
+color_t bricks_get_color(const brick_grid_t *grid, int row, int col) {
+    uint8_t cell = grid->cell[row][col];
+    color_t color = palette[BRICK_CELL_COLOR(cell)];
+    uint32_t hp = BRICK_CELL_HP(cell);
+    if (hp <= 1) return color;
+    uint32_t a = (hp - 1) * HP_SHADE;
+    return lighten(color, a < HP_SHADE_MAX ? a : HP_SHADE_MAX);
+}
+
+/************************ Collision Detection *************************/
+// Range of cells along one axis that overlap the interval [lo, hi].
+// Cell i spans [spacing + i*pitch, spacing + i*pitch + size].
+// Return false if no cell overlaps.
+static bool cell_range(phys_t lo, phys_t hi, int spacing, phys_t size,
+                       int n, int *first, int *last)
+{
+    phys_t sp = phys_from_int(spacing);
+    phys_t pitch = size + sp;
+    int32_t f = phys_ceil(phys_div(lo - sp - size, pitch));
+    int32_t l = phys_floor(phys_div(hi - sp, pitch));
+    if (f < 0) f = 0;
+    if (l > n - 1) l = n - 1;
+    if (f > l) return false;
+    *first = f;
+    *last = l;
+    return true;
+}
 
-                float diff_x = ball_x - brick_center_x;
-                float diff_y = ball_y - brick_center_y;
+bool bricks_find(const brick_grid_t *grid, phys_t x, phys_t y, phys_t radius,
+                 int *row, int *col)
+{
+    if (!grid) return false;
+
+    int c0, c1, r0, r1;
+    if (!cell_range(x - radius, x + radius, grid->spacing_x, grid->brick_w,
+                    grid->cols, &c0, &c1) ||
+        !cell_range(y - radius, y + radius, grid->spacing_y, grid->brick_h,
+                    grid->rows, &r0, &r1))
+        return false;
 
-                // Decide bounce axis
-                if (fabsf(diff_x) > fabsf(diff_y)) {
-                    game_ball.dx *= -1;   // Horizontal bounce
-                } else {
-                    game_ball.dy *= -1;   // Vertical bounce
-                }
-                sound_start(userSound, USERSOUND_SAMPLES, false);
-                // Mark brick for removal
-                b->destroy_me = true;
+    // Alive bricks in columns c0 to c1
+    brick_mask_t span = low_mask(c1 + 1) & ~low_mask(c0);
+    for (int r = r0; r <= r1; r++) {
+        for (brick_mask_t bits = grid->alive[r] & span; bits; bits &= bits - 1) {
+            int c = CTZ(bits);
+            phys_t bx, by, bw, bh;
+            bricks_get_box(grid, r, c, &bx, &by, &bw, &bh);
+
+            // ------- AABB-circle collision -------
+            phys_t dx = x - phys_clamp(x, bx, bx + bw);
+            phys_t dy = y - phys_clamp(y, by, by + bh);
 
+            if (phys_mul2(dx, dx) + phys_mul2(dy, dy) <= phys_mul2(radius, radius)) {
+                *row = r;
+                *col = c;
                 return true;
             }
         }
@@ -176,25 +251,89 @@ bool bricks_check_collision(brick_grid_t *grid,
     return false;
 }
 
-bool bricks_all_cleared(brick_grid_t *grid) {
+bool bricks_sweep(const brick_grid_t *grid, phys_t x, phys_t y,
+                  phys_t mx, phys_t my, phys_t radius,
+                  phys_t *t, int *row, int *col, phys_t *nx, phys_t *ny)
+{
     if (!grid) return false;
+
+    // Cells under the bounding box of the whole motion
+    int c0, c1, r0, r1;
+    if (!cell_range(phys_min(x, x + mx) - radius, phys_max(x, x + mx) + radius,
+                    grid->spacing_x, grid->brick_w, grid->cols, &c0, &c1) ||
+        !cell_range(phys_min(y, y + my) - radius, phys_max(y, y + my) + radius,
+                    grid->spacing_y, grid->brick_h, grid->rows, &r0, &r1))
+        return false;
+
+    bool found = false;
+    brick_mask_t span = low_mask(c1 + 1) & ~low_mask(c0);
+    for (int r = r0; r <= r1; r++) {
+        for (brick_mask_t bits = grid->alive[r] & span; bits; bits &= bits - 1) {
+            int c = CTZ(bits);
+            phys_t bx, by, bw, bh, ht, hnx, hny;
+            bricks_get_box(grid, r, c, &bx, &by, &bw, &bh);
+            if (collide_sweep_box(x, y, mx, my, radius, bx, by, bw, bh,
+                                  &ht, &hnx, &hny) && (!found || ht < *t)) {
+                found = true;
+                *t = ht; *row = r; *col = c; *nx = hnx; *ny = hny;
+            }
+        }
+    }
+
+    return found;
+}
+
+void bricks_destroy(brick_grid_t *grid, int row, int col) {
+    if (!grid || !(grid->alive[row] & BIT(col))) return;
     
-    for (int r = 0; r < grid->rows; r++)
-        for (int c = 0; c < grid->cols; c++)
-            if (grid->bricks[r][c].currentState == alive_st)
-                return false;
+    grid->alive[row] &= ~BIT(col);
+    grid->alive_count--;
+    grid->dirty[row] |= BIT(col);
+}
+
+bool bricks_hit(brick_grid_t *grid, int row, int col) {
+    if (!grid || !(grid->alive[row] & BIT(col))) return false;
 
+    uint8_t cell = grid->cell[row][col];
+    if (BRICK_CELL_HP(cell) > 1) {
+        grid->cell[row][col] = cell - BRICK_CELL(0, 1);
+        grid->dirty[row] |= BIT(col);
+        return false;
+    }
+    bricks_destroy(grid, row, col);
     return true;
 }
 
-uint32_t bricks_get_alive_count(brick_grid_t *grid) {
-    if (!grid) return 0;
+bool bricks_is_alive(const brick_grid_t *grid, int row, int col) {
+    if (!grid) return false;
     
-    uint32_t count = 0;
-    for (int r = 0; r < grid->rows; r++)
-        for (int c = 0; c < grid->cols; c++)
-            if (grid->bricks[r][c].currentState == alive_st)
-                count++;
+    return grid->alive[row] & BIT(col);
+}
 
-    return count;
+brick_iter_t bricks_iter(const brick_grid_t *grid) {
+    brick_iter_t it = {grid, 0, grid->rows ? grid->alive[0] : 0};
+    return it;
+}
+
+bool bricks_next(brick_iter_t *it, int *row, int *col) {
+    while (!it->bits) {
+        if (++it->row >= it->grid->rows) return false;
+        it->bits = it->grid->alive[it->row];
+    }
+    *row = it->row;
+    *col = CTZ(it->bits);
+    it->bits &= it->bits - 1;
+    return true;
+}
+
+bool bricks_all_cleared(const brick_grid_t *grid) {
+    if (!grid) return false;
+    
+    return grid->alive_count == 0;
+}
+
+uint32_t bricks_get_alive_count(const brick_grid_t *grid) {
+    if (!grid) return 0;
+    
+    return grid->alive_count;
 }
@@ -4,45 +4,147 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "lcd.h"
+#include "phys.h"
 
+#ifndef MAX_BRICK_ROWS
 #define MAX_BRICK_ROWS 8
+#endif
+#ifndef MAX_BRICK_COLS
 #define MAX_BRICK_COLS 12
+#endif
+// Render ids 0 to MAX_BRICK_ROWS*MAX_BRICK_COLS-1 are used by the bricks
 
-// Single brick structure
-typedef struct {
-    float x;                    // X position
-    float y;                    // Y position
-    float width;                // Brick width
-    float height;               // Brick height
-    color_t color;              // Brick color
-    uint32_t currentState;      // Current state
-    bool destroy_me;            // Flag to destroy brick
-} brick_t;
-
-// Grid of bricks
+// One bit per brick in a row, bit c is column c
+#if MAX_BRICK_COLS <= 16
+typedef uint16_t brick_mask_t;
+#elif MAX_BRICK_COLS <= 32
+typedef uint32_t brick_mask_t;
+#elif MAX_BRICK_COLS <= 64
+typedef uint64_t brick_mask_t;
+#else
+#error "MAX_BRICK_COLS must be 64 or less"
+#endif
+
+// Brick cell: palette color index in the low nibble (0 for no brick),
+// hit points left in the high nibble (1 to BRICK_HP_MAX)
+#define BRICK_HP_MAX 15
+#define BRICK_CELL(color, hp) ((uint8_t)(((hp) << 4) | ((color) & 0xF)))
+#define BRICK_CELL_COLOR(cell) ((cell) & 0xF)
+#define BRICK_CELL_HP(cell) ((cell) >> 4)
+
+// Grid of bricks. Liveness is kept in row masks for the collision tests,
+// and each cell holds the brick's color and hit points. The position and
+// size of a brick are derived from its row and column.
+//
+// Cells that change (a brick created, damaged or destroyed, or a new
+// layout) are marked in the dirty masks, and only those are drawn or
+// erased by bricks_draw(). The owner clears the marks with bricks_clean()
+// once a copy has been taken for drawing.
 typedef struct {
-    brick_t bricks[MAX_BRICK_ROWS][MAX_BRICK_COLS];
-    int rows;                   // Number of rows in use
-    int cols;                   // Number of columns in use
-    int spacing_x;              // Horizontal spacing
-    int spacing_y;              // Vertical spacing
+    brick_mask_t alive[MAX_BRICK_ROWS]; // Alive bricks in each row
+    brick_mask_t dirty[MAX_BRICK_ROWS]; // Changed cells in each row
+    uint8_t cell[MAX_BRICK_ROWS][MAX_BRICK_COLS]; // See BRICK_CELL
+    uint16_t alive_count;       // Number of alive bricks
+    uint8_t rows;               // Number of rows in use
+    uint8_t cols;               // Number of columns in use
+    uint8_t spacing_x;          // Horizontal spacing
+    uint8_t spacing_y;          // Vertical spacing
+    phys_t brick_w;             // Width of every brick
+    phys_t brick_h;             // Height of every brick
 } brick_grid_t;
 
+// Iterator over alive bricks in row-major order
+typedef struct {
+    const brick_grid_t *grid;
+    int row;                    // Current row
+    brick_mask_t bits;          // Alive bricks not yet visited in the row
+} brick_iter_t;
+
 /************************ Function Prototypes *************************/
 
-// Initialize brick grid
+// Initialize brick grid with the default layout
 void bricks_init(brick_grid_t *grid);
 
-// Main tick function for all bricks
-void bricks_tick(brick_grid_t *grid);
+// Initialize brick grid with a layout. Bricks are spaced evenly and fill
+// the screen width. Every cell gets a brick with one hit point, colored
+// by row; see bricks_set_cell() to change them (e.g. from a level).
+// rows, cols: size of the grid, up to MAX_BRICK_ROWS, MAX_BRICK_COLS.
+// spacing_x, spacing_y: gap between bricks and around the grid.
+// brick_h: height of a brick.
+void bricks_init_layout(brick_grid_t *grid, int rows, int cols,
+                        int spacing_x, int spacing_y, phys_t brick_h);
+
+// Draw the dirty bricks, and the ones overlapped by an erase (see
+// render_stale()), and erase the dirty cells with no brick (call every
+// frame). The cost is near zero when nothing changed.
+void bricks_draw(const brick_grid_t *grid);
+
+// Clear the dirty marks (after a copy of the grid was taken for drawing)
+void bricks_clean(brick_grid_t *grid);
+
+// Mark every cell dirty (e.g. for a new layout)
+void bricks_touch(brick_grid_t *grid);
+
+// Replace a grid with another (e.g. a saved one), marking dirty the cells
+// that differ, or every cell if the layout differs.
+// src: grid copied.
+void bricks_copy(brick_grid_t *grid, const brick_grid_t *src);
+
+// Add the dirty marks of a copy that was never drawn.
+// older: the copy, taken before the grid.
+void bricks_merge_dirty(brick_grid_t *grid, const brick_grid_t *older);
+
+// Find the first alive brick that overlaps a circle. Only the cells under
+// the circle's bounding box are tested, so the cost doesn't depend on the
+// size of the grid.
+// *row, *col: set to the brick's cell if found.
+// Return true if a brick was found.
+bool bricks_find(const brick_grid_t *grid, phys_t x, phys_t y, phys_t radius,
+                 int *row, int *col);
+
+// Find the alive brick hit first by a moving circle (see collide.h).
+// x, y: center at the start; mx, my: motion; radius: circle radius.
+// *t: time of impact, 0 to 1; *row, *col: the brick's cell;
+// *nx, *ny: contact normal.
+// Return true if a brick is hit.
+bool bricks_sweep(const brick_grid_t *grid, phys_t x, phys_t y,
+                  phys_t mx, phys_t my, phys_t radius,
+                  phys_t *t, int *row, int *col, phys_t *nx, phys_t *ny);
+
+// Destroy the brick in a cell (no effect if already destroyed)
+void bricks_destroy(brick_grid_t *grid, int row, int col);
+
+// Take a hit point off the brick in a cell, destroying it at zero.
+// Return true if the brick was destroyed.
+bool bricks_hit(brick_grid_t *grid, int row, int col);
+
+// Set a cell of a grid set up by bricks_init_layout().
+// cell: BRICK_CELL(color, hp), or 0 for no brick.
+void bricks_set_cell(brick_grid_t *grid, int row, int col, uint8_t cell);
+
+// Check if the brick in a cell is alive
+bool bricks_is_alive(const brick_grid_t *grid, int row, int col);
+
+// Get the box of the brick in a cell
+void bricks_get_box(const brick_grid_t *grid, int row, int col,
+                    phys_t *x, phys_t *y, phys_t *w, phys_t *h);
+
+// Get the color of the brick in a cell: the palette color with one hit
+// point left, lighter for each hit point more
+color_t bricks_get_color(const brick_grid_t *grid, int row, int col);
+
+// Start iterating over alive bricks
+brick_iter_t bricks_iter(const brick_grid_t *grid);
 
-// Check collision with ball
-bool bricks_check_collision(brick_grid_t *grid, float ball_x, float ball_y, float ball_radius);
+// Get the next alive brick.
+// *row, *col: set to the brick's cell.
+// Return false when there are no more bricks.
+bool bricks_next(brick_iter_t *it, int *row, int *col);
 
 // Check if all bricks are cleared
-bool bricks_all_cleared(brick_grid_t *grid);
+bool bricks_all_cleared(const brick_grid_t *grid);
 
 // Get count of alive bricks
-uint32_t bricks_get_alive_count(brick_grid_t *grid);
+uint32_t bricks_get_alive_count(const brick_grid_t *grid);
 
-#endif // BRICK_H
\ No newline at end of file
+#endif // BRICK_H
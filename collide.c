@@ -0,0 +1,216 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lcd.h"
+#include "phys.h"
+#include "ball.h"
+#include "balls.h"
+#include "brick.h"
+#include "collide.h"
+
+#define SCREEN_WIDTH LCD_W
+
+/************************ Sweep Tests *************************/
+// Contact at the start of the motion, for a circle already overlapping the
+// box (e.g. the platform moved into the ball).
+static bool overlap_contact(phys_t x, phys_t y, phys_t mx, phys_t my, phys_t r,
+                            phys_t bx, phys_t by, phys_t bw, phys_t bh,
+                            phys_t *t, phys_t *nx, phys_t *ny)
+{
+    phys_t qx = phys_clamp(x, bx, bx + bw);
+    phys_t qy = phys_clamp(y, by, by + bh);
+    phys_t dx = x - qx, dy = y - qy;
+    phys2_t d2 = phys_mul2(dx, dx) + phys_mul2(dy, dy);
+    if (d2 >= phys_mul2(r, r)) return false;
+
+    phys_t ux, uy;
+    if (d2 > 0) {
+        phys_t d = phys_sqrt2(d2);
+        ux = phys_div(dx, d); uy = phys_div(dy, d);
+    } else { // Center inside the box, leave by the nearest side
+        phys_t l = x - bx, rt = bx + bw - x, tp = y - by, bt = by + bh - y;
+        phys_t m = phys_min(phys_min(l, rt), phys_min(tp, bt));
+        ux = m == l ? -PHYS_ONE : m == rt ? PHYS_ONE : 0;
+        uy = ux ? 0 : m == tp ? -PHYS_ONE : PHYS_ONE;
+    }
+    if (phys_mul2(mx, ux) + phys_mul2(my, uy) >= 0) return false; // Moving out
+    *t = 0; *nx = ux; *ny = uy;
+    return true;
+}
+
+bool collide_sweep_box(phys_t x, phys_t y, phys_t mx, phys_t my, phys_t r,
+                       phys_t bx, phys_t by, phys_t bw, phys_t bh,
+                       phys_t *t, phys_t *nx, phys_t *ny)
+{
+    if (overlap_contact(x, y, mx, my, r, bx, by, bw, bh, t, nx, ny))
+        return true;
+
+    // Ray against the box grown by r (slab test)
+    phys_t ex0 = bx - r, ex1 = bx + bw + r;
+    phys_t ey0 = by - r, ey1 = by + bh + r;
+    phys_t tx0 = PHYS_MIN, tx1 = PHYS_MAX, ty0 = PHYS_MIN, ty1 = PHYS_MAX;
+    if (mx != 0) {
+        phys_t a = phys_div(ex0 - x, mx), b = phys_div(ex1 - x, mx);
+        tx0 = phys_min(a, b); tx1 = phys_max(a, b);
+    } else if (x < ex0 || x > ex1) return false;
+    if (my != 0) {
+        phys_t a = phys_div(ey0 - y, my), b = phys_div(ey1 - y, my);
+        ty0 = phys_min(a, b); ty1 = phys_max(a, b);
+    } else if (y < ey0 || y > ey1) return false;
+
+    phys_t tin = phys_max(tx0, ty0), tout = phys_min(tx1, ty1);
+    if (tin > tout || tin > PHYS_ONE || tout < 0) return false;
+
+    // Entry point on the grown box
+    phys_t hx = x + phys_mul(mx, tin), hy = y + phys_mul(my, tin);
+    bool out_x = hx < bx || hx > bx + bw;
+    bool out_y = hy < by || hy > by + bh;
+    if (tin >= 0 && !(out_x && out_y)) { // Flat side
+        if (tx0 > ty0) { *nx = mx > 0 ? -PHYS_ONE : PHYS_ONE; *ny = 0; }
+        else           { *nx = 0; *ny = my > 0 ? -PHYS_ONE : PHYS_ONE; }
+        *t = tin;
+        return true;
+    }
+
+    // Rounded corner: ray against a circle of radius r at the corner.
+    // With the ray's length len, proj is the distance along the ray to the
+    // point closest to the corner, and perp2 the squared distance there.
+    if (tin < 0) { hx = x; hy = y; } // Started in the corner's square
+    phys_t cx = hx < bx + bw/2 ? bx : bx + bw;
+    phys_t cy = hy < by + bh/2 ? by : by + bh;
+    phys_t fx = x - cx, fy = y - cy;
+    phys2_t fm = phys_mul2(fx, mx) + phys_mul2(fy, my);
+    phys2_t mm = phys_mul2(mx, mx) + phys_mul2(my, my);
+    if (mm == 0 || fm >= 0) return false; // Not moving or moving away
+    phys_t len = phys_sqrt2(mm);
+    phys_t proj = -phys_div2(fm, len);
+    phys2_t perp2 = phys_mul2(fx, fx) + phys_mul2(fy, fy) - phys_mul2(proj, proj);
+    phys2_t rr = phys_mul2(r, r);
+    if (perp2 > rr) return false; // Miss
+    phys_t s = proj - phys_sqrt2(rr - perp2); // Distance to contact
+    if (s < 0 || s > len) return false;
+    phys_t tc = phys_div(s, len);
+    *t = tc;
+    *nx = phys_div(fx + phys_mul(mx, tc), r);
+    *ny = phys_div(fy + phys_mul(my, tc), r);
+    return true;
+}
+
+bool collide_sweep_walls(phys_t x, phys_t y, phys_t mx, phys_t my, phys_t r,
+                         phys_t *t, phys_t *nx, phys_t *ny)
+{
+    const phys_t w = phys_from_int(SCREEN_WIDTH);
+    phys_t best = PHYS_MAX;
+
+    if (mx < 0 && x + mx - r < 0) {
+        best = phys_max(phys_div(r - x, mx), 0);
+        *nx = PHYS_ONE; *ny = 0;
+    } else if (mx > 0 && x + mx + r > w) {
+        best = phys_max(phys_div(w - r - x, mx), 0);
+        *nx = -PHYS_ONE; *ny = 0;
+    }
+    if (my < 0 && y + my - r < 0) {
+        phys_t tt = phys_max(phys_div(r - y, my), 0);
+        if (tt < best) {
+            best = tt;
+            *nx = 0; *ny = PHYS_ONE;
+        }
+    }
+    if (best > PHYS_ONE) return false;
+    *t = best;
+    return true;
+}
+
+/************************ Ball Motion *************************/
+// Move one ball by dt seconds with contacts in time order.
+// *broken: incremented for each brick destroyed.
+// Return the COLLIDE_* bits of what was hit.
+static uint32_t move(phys_t *x, phys_t *y, phys_t *dx, phys_t *dy,
+                     phys_t r, phys_t speed, phys_t dt, brick_grid_t *bricks,
+                     phys_t px, phys_t py, phys_t pw, phys_t ph,
+                     uint32_t *broken)
+{
+    uint32_t hits = 0;
+    phys_t rem = phys_mul(dt, speed); // Time left to move, at base velocity
+
+    for (uint32_t i = 0; i < COLLIDE_MAX_CONTACTS && rem > 0; i++) {
+        phys_t mx = phys_mul(*dx, rem), my = phys_mul(*dy, rem);
+
+        // Earliest contact
+        uint32_t hit = 0;
+        phys_t t = PHYS_MAX, nx = 0, ny = 0;
+        phys_t ht, hnx, hny;
+        int row = 0, col = 0;
+        if (collide_sweep_walls(*x, *y, mx, my, r, &ht, &hnx, &hny) &&
+            ht < t) {
+            hit = COLLIDE_WALL; t = ht; nx = hnx; ny = hny;
+        }
+        if (collide_sweep_box(*x, *y, mx, my, r, px, py, pw, ph,
+                              &ht, &hnx, &hny) && ht < t) {
+            hit = COLLIDE_PLATFORM; t = ht; nx = hnx; ny = hny;
+        }
+        if (bricks_sweep(bricks, *x, *y, mx, my, r,
+                         &ht, &row, &col, &hnx, &hny) && ht < t) {
+            hit = COLLIDE_BRICK; t = ht; nx = hnx; ny = hny;
+        }
+
+        if (!hit) {
+            *x += mx;
+            *y += my;
+            break;
+        }
+
+        // Move to the contact and bounce
+        *x += phys_mul(mx, t);
+        *y += phys_mul(my, t);
+        rem -= phys_mul(rem, t);
+        if (hit == COLLIDE_PLATFORM && ny < 0) { // Top of the platform
+            ball_reflect_platform(*x, dx, dy, px, pw);
+        } else {
+            ball_reflect(dx, dy, nx, ny);
+        }
+        if (hit == COLLIDE_BRICK && bricks_hit(bricks, row, col))
+            (*broken)++;
+        hits |= hit;
+    }
+
+    return hits;
+}
+
+collide_result_t collide_move_ball(ball_t *ball, phys_t dt,
+                                   brick_grid_t *bricks,
+                                   phys_t px, phys_t py, phys_t pw, phys_t ph)
+{
+    collide_result_t res = {0, 0, 0, 0};
+    if (!ball) return res;
+
+    res.hits = move(&ball->x, &ball->y, &ball->dx, &ball->dy, ball->radius,
+                    ball_get_speed(), dt, bricks, px, py, pw, ph, &res.bricks);
+    res.x = ball->x;
+    res.y = ball->y;
+    return res;
+}
+
+collide_result_t collide_move_balls(ball_set_t *set, phys_t dt,
+                                    brick_grid_t *bricks,
+                                    phys_t px, phys_t py, phys_t pw, phys_t ph)
+{
+    collide_result_t res = {0, 0, 0, 0};
+    if (!set) return res;
+
+    phys_t speed = ball_get_speed();
+    for (int32_t w = 0; w < BALLS_WORDS; w++) {
+        for (uint32_t bits = set->active[w]; bits; bits &= bits - 1) {
+            int32_t i = w*32 + __builtin_ctz(bits);
+            uint32_t hits = move(&set->x[i], &set->y[i], &set->dx[i], &set->dy[i],
+                                 set->radius, speed, dt, bricks, px, py, pw, ph,
+                                 &res.bricks);
+            if (hits && !res.hits) {
+                res.x = set->x[i];
+                res.y = set->y[i];
+            }
+            res.hits |= hits;
+        }
+    }
+    return res;
+}
@@ -0,0 +1,65 @@
+#ifndef COLLIDE_H_
+#define COLLIDE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "phys.h"
+#include "ball.h"
+#include "balls.h"
+#include "brick.h"
+
+// Continuous collision for the ball. Instead of testing for overlap at the
+// end of a step, the ball's motion is swept as a segment and the time of
+// impact (TOI) with each surface is found. The earliest contact is
+// resolved, and the ball continues with the time left, so it can't pass
+// through a brick or the platform at any speed.
+//
+// A circle moving against a box is the same as the circle's center moving
+// against the box grown by the radius, with rounded corners. Times are a
+// fraction of the motion, 0 to 1. All arithmetic is in phys_t (phys.h).
+
+#define COLLIDE_MAX_CONTACTS 8 // Contacts resolved per step per ball
+
+// What a ball hit (bits of collide_result_t.hits)
+#define COLLIDE_WALL     0x1
+#define COLLIDE_PLATFORM 0x2
+#define COLLIDE_BRICK    0x4
+
+// Outcome of moving balls, for the caller to respond to (sound, score)
+typedef struct {
+    uint32_t bricks; // Bricks destroyed
+    uint32_t hits;   // COLLIDE_* bits of what was hit
+    phys_t x, y;     // Center of the (first) ball that hit, after the move
+} collide_result_t;
+
+// Sweep a circle against a box.
+// x, y: center at the start; mx, my: motion; r: radius.
+// bx, by, bw, bh: box.
+// *t: time of impact; *nx, *ny: unit contact normal, out of the box.
+// Return true if the circle hits the box while moving into it.
+bool collide_sweep_box(phys_t x, phys_t y, phys_t mx, phys_t my, phys_t r,
+                       phys_t bx, phys_t by, phys_t bw, phys_t bh,
+                       phys_t *t, phys_t *nx, phys_t *ny);
+
+// Sweep a circle against the left, right and top of the screen.
+// Arguments as for collide_sweep_box.
+// Return true if the circle hits a wall while moving into it.
+bool collide_sweep_walls(phys_t x, phys_t y, phys_t mx, phys_t my, phys_t r,
+                         phys_t *t, phys_t *nx, phys_t *ny);
+
+// Move a ball by dt seconds, bouncing off the walls, the platform and the
+// bricks in time order. Bricks hit lose a hit point (see bricks_hit()).
+// px, py, pw, ph: platform box.
+// Return what was hit.
+collide_result_t collide_move_ball(ball_t *ball, phys_t dt,
+                                   brick_grid_t *bricks,
+                                   phys_t px, phys_t py, phys_t pw, phys_t ph);
+
+// Move every ball in a set by dt seconds, as collide_move_ball().
+// Return what was hit by any of them, at the first one that hit.
+collide_result_t collide_move_balls(ball_set_t *set, phys_t dt,
+                                    brick_grid_t *bricks,
+                                    phys_t px, phys_t py, phys_t pw, phys_t ph);
+
+#endif // COLLIDE_H_
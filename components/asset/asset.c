@@ -0,0 +1,143 @@
+#include <string.h> // strncmp
+
+#include "esp_partition.h"
+#include "esp_log.h"
+
+#include "asset.h"
+
+#define ASSET_MAGIC   0x54455341U // "ASET"
+#define ASSET_VERSION 1U
+
+#define FNV_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+// Blob header, located at the start of the partition.
+typedef struct {
+	uint32_t magic;   // ASSET_MAGIC
+	uint16_t version; // ASSET_VERSION
+	uint16_t count;   // Number of assets
+	uint16_t slots;   // Number of index slots (power of two)
+	uint16_t rsv;
+	uint32_t size;    // Total size of blob in bytes
+} asset_hdr_t;
+
+// Index entry. A hash of zero marks an empty slot.
+typedef struct {
+	uint32_t hash;   // Hash of name, never zero
+	uint32_t offset; // Offset of data from start of blob
+	uint32_t size;   // Size of data in bytes
+	uint16_t w;
+	uint16_t h;
+	uint8_t  fmt;
+	uint8_t  rsv[3];
+	char     name[ASSET_NAME_LEN];
+} asset_ent_t;
+
+static const char *TAG = "asset";
+
+static esp_partition_mmap_handle_t map_handle;
+static const uint8_t *base; // Start of mapped blob, NULL if not mapped
+static uint32_t map_size;   // Bytes mapped (partition size)
+static const asset_hdr_t *hdr;
+static const asset_ent_t *table;
+
+
+// FNV-1a hash of a name. Must match the hash in image/asset_pack.m.
+static uint32_t asset_hash(const char *name)
+{
+	uint32_t h = FNV_BASIS;
+	for (uint32_t i = 0; name[i] && i < ASSET_NAME_LEN-1; i++) {
+		h ^= (uint8_t)name[i];
+		h *= FNV_PRIME;
+	}
+	return h ? h : 1;
+}
+
+// Map the asset blob in a data partition into the address space.
+// May be called again to map a different partition.
+// label: partition label, or NULL for ASSET_PART_LABEL.
+// Return zero if successful, or non-zero otherwise.
+int32_t asset_init(const char *label)
+{
+	const esp_partition_t *part;
+	const void *ptr;
+
+	if (base != NULL) asset_deinit();
+	if (label == NULL) label = ASSET_PART_LABEL;
+
+	part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+		ESP_PARTITION_SUBTYPE_ANY, label);
+	if (part == NULL) {
+		ESP_LOGE(TAG, "partition '%s' not found", label);
+		return -1;
+	}
+	if (esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA,
+		&ptr, &map_handle) != ESP_OK) {
+		ESP_LOGE(TAG, "partition '%s' mmap fail", label);
+		return -1;
+	}
+
+	// Validate the blob before handing out pointers into it.
+	const asset_hdr_t *h = ptr;
+	if (h->magic != ASSET_MAGIC || h->version != ASSET_VERSION ||
+		h->size > part->size || h->slots == 0 || (h->slots & (h->slots-1)) ||
+		sizeof(asset_hdr_t) + h->slots*sizeof(asset_ent_t) > h->size) {
+		ESP_LOGE(TAG, "partition '%s' has no valid asset blob", label);
+		esp_partition_munmap(map_handle);
+		return -1;
+	}
+	base = ptr;
+	map_size = part->size;
+	hdr = h;
+	table = (const asset_ent_t *)(base + sizeof(asset_hdr_t));
+	ESP_LOGI(TAG, "mapped %u assets, %lu bytes", hdr->count, (unsigned long)hdr->size);
+	return 0;
+}
+
+// Unmap the asset blob. Pointers to asset data become invalid.
+// Return zero if successful, or non-zero otherwise.
+int32_t asset_deinit(void)
+{
+	if (base == NULL) return 0;
+	esp_partition_munmap(map_handle);
+	base = NULL;
+	map_size = 0;
+	hdr = NULL;
+	table = NULL;
+	return 0;
+}
+
+// Look up an asset by name. The lookup is a hash table probe, so the
+// cost does not depend on the number of assets in the blob.
+// name: name of the asset (file name without extension).
+// *asset: pointer to description filled in if found.
+// Return zero if found, or non-zero otherwise.
+int32_t asset_get(const char *name, asset_t *asset)
+{
+	if (base == NULL || name == NULL || asset == NULL) return -1;
+
+	uint32_t h = asset_hash(name);
+	uint32_t mask = hdr->slots-1;
+	// Linear probe until the name matches or an empty slot is found.
+	for (uint32_t i = 0, s = h & mask; i < hdr->slots; i++, s = (s+1) & mask) {
+		const asset_ent_t *e = &table[s];
+		if (e->hash == 0) break;
+		if (e->hash != h || strncmp(e->name, name, ASSET_NAME_LEN-1)) continue;
+		// Data must lie in the blob and the mapping (no wrap on the sum)
+		uint32_t end = (hdr->size < map_size) ? hdr->size : map_size;
+		if (e->offset > end || e->size > end - e->offset) return -1;
+		asset->data = base + e->offset;
+		asset->size = e->size;
+		asset->w = e->w;
+		asset->h = e->h;
+		asset->fmt = e->fmt;
+		return 0;
+	}
+	return -1;
+}
+
+// Return the number of assets in the blob, or zero if not mapped.
+uint32_t asset_count(void)
+{
+	return (base != NULL) ? hdr->count : 0;
+}
@@ -0,0 +1,59 @@
+#ifndef ASSET_H_
+#define ASSET_H_
+
+#include <stdint.h>
+
+// This component provides read-only access to assets (images, level data,
+// etc.) packed into a single blob and flashed to a data partition. The
+// partition is memory mapped, so asset data is read directly from flash
+// through the cache and is never copied to RAM. Pointers returned by this
+// component can be passed straight to drawing functions such as
+// lcd_drawRGBBitmap() and remain valid until asset_deinit() is called.
+// Use image/asset_pack.m to create a blob from a set of images.
+//
+// Blob layout (little endian):
+//   header: magic "ASET", version, entry count, index slot count, blob size
+//   index:  slot count entries (power of two), open addressed by name hash
+//   data:   asset data, each starting on a 4 byte boundary
+
+#define ASSET_PART_LABEL "storage" // Default partition label
+#define ASSET_NAME_LEN 16 // Maximum name length including terminator
+
+// Format of the data referenced by an asset.
+typedef enum {
+	ASSET_FMT_RAW,    // Uninterpreted bytes
+	ASSET_FMT_RGB565, // Color array for lcd_drawRGBBitmap()
+	ASSET_FMT_RLE565, // RLE packets for lcd_drawImageRLE()
+	ASSET_FMT_MONO,   // 1-bit bitmap for lcd_drawBitmap()
+} asset_fmt_t;
+
+// Description of an asset. The data pointer addresses mapped flash.
+typedef struct {
+	const void *data; // Pointer to asset data
+	uint32_t size;    // Size of data in bytes
+	uint16_t w;       // Image width in pixels (zero if not an image)
+	uint16_t h;       // Image height in pixels (zero if not an image)
+	asset_fmt_t fmt;  // Format of data
+} asset_t;
+
+// Map the asset blob in a data partition into the address space.
+// May be called again to map a different partition.
+// label: partition label, or NULL for ASSET_PART_LABEL.
+// Return zero if successful, or non-zero otherwise.
+int32_t asset_init(const char *label);
+
+// Unmap the asset blob. Pointers to asset data become invalid.
+// Return zero if successful, or non-zero otherwise.
+int32_t asset_deinit(void);
+
+// Look up an asset by name. The lookup is a hash table probe, so the
+// cost does not depend on the number of assets in the blob.
+// name: name of the asset (file name without extension).
+// *asset: pointer to description filled in if found.
+// Return zero if found, or non-zero otherwise.
+int32_t asset_get(const char *name, asset_t *asset);
+
+// Return the number of assets in the blob, or zero if not mapped.
+uint32_t asset_count(void);
+
+#endif // ASSET_H_
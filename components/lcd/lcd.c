@@ -6,37 +6,31 @@
 //   https://github.com/adafruit/Adafruit_ILI9341
 
 #include <string.h> // strlen, memcpy
+#include <stdlib.h> // abs
 #include <math.h> // cosf, sinf
-
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-
-#include "driver/spi_master.h"
-#include "driver/gpio.h"
-#include "esp_heap_caps.h"
-#include "esp_log.h"
+#include <sys/types.h> // ssize_t
 
 #include "hw.h"
 #include "lcd.h"
+#include "lcd_io.h"
 
 #define _DEBUG_ 0
 
-#define LCD_MOSI HW_LCD_MOSI
-#define LCD_SCLK HW_LCD_SCLK
-#define LCD_CS   HW_LCD_CS
-#define LCD_DC   HW_LCD_DC
-#define LCD_RST  HW_LCD_RST
-#define LCD_BL   HW_LCD_BL
-
 #define LCD_INV      HW_LCD_INV
-#define LCD_SPI_HOST HW_LCD_SPI_HOST
-#define LCD_SPI_FREQ HW_LCD_SPI_FREQ
 
 #define LCD_OFFSETX HW_LCD_OFFSETX
 #define LCD_OFFSETY HW_LCD_OFFSETY
 
 #define LCD_DRIVER HW_LCD_DRIVER
 
+// COLMOD (3Ah) parameter for each pixel format
+#if LCD_DRIVER == 0
+#define COLMOD_RGB565 0x55
+#else
+#define COLMOD_RGB565 0x05
+#define COLMOD_RGB444 0x03
+#endif
+
 #define swap(T,a,b) {T t = (a); (a) = (b); (b) = t;}
 
 #define M_PIf 3.14159265358979323846f
@@ -52,192 +46,128 @@ typedef struct {
 	uint8_t     font_size;
 	bool        font_back_en;
 	color_t     font_back_color;
-	int8_t      res;
-	int8_t      dc;
-	int8_t      bl;
-	spi_device_handle_t SPIHandle;
 	bool        use_frame_buffer;
 	color_t   *frame_buffer;
+	present_t   present_mode;
+	format_t    pixel_format;
+	uint8_t     field; // Next interlaced field, 0:even, 1:odd rows
 } TFT_t;
 
-typedef enum {
-	SPI_Command_Mode = 0,
-	SPI_Data_Mode = 1
-} spi_mode_t;
-
 static TFT_t device;
 static TFT_t *dev = &device;
 
 static const char *TAG = "lcd";
 
-static int32_t clock_freq_hz = LCD_SPI_FREQ;
-
 #include "glcdfont.c" // unsigned char font[];
 
-#define delayMS(ms) \
-	vTaskDelay(((ms)+(portTICK_PERIOD_MS-1))/portTICK_PERIOD_MS)
+#define delayMS(ms) lcd_io_delay(ms)
 
 //----------------------------------------------------------------------------//
-// SPI
+// Panel encoding
 //----------------------------------------------------------------------------//
 
+// Bounce buffer for encoding pixels in the panel byte order.
 #define BUF_LEN 512
 static uint16_t buffer[BUF_LEN];
 
-static void spi_master_init(TFT_t *dev, int16_t GPIO_MOSI, int16_t GPIO_SCLK, int16_t GPIO_CS, int16_t GPIO_DC, int16_t GPIO_RST, int16_t GPIO_BL)
-{
-	esp_err_t ret;
-
-	ESP_LOGI(TAG, "GPIO_BL=%hd", GPIO_BL);
-	if ( GPIO_BL >= 0 ) {
-		gpio_reset_pin(GPIO_BL);
-		gpio_set_direction( GPIO_BL, GPIO_MODE_OUTPUT );
-		gpio_set_level( GPIO_BL, 0 );
-	}
-
-	ESP_LOGI(TAG, "GPIO_CS=%hd",GPIO_CS);
-	if ( GPIO_CS >= 0 ) {
-		gpio_reset_pin( GPIO_CS );
-		gpio_set_direction( GPIO_CS, GPIO_MODE_OUTPUT );
-		gpio_set_level( GPIO_CS, 0 );
-	}
-
-	ESP_LOGI(TAG, "GPIO_DC=%hd",GPIO_DC);
-	gpio_reset_pin( GPIO_DC );
-	gpio_set_direction( GPIO_DC, GPIO_MODE_OUTPUT );
-	gpio_set_level( GPIO_DC, 0 );
-
-	ESP_LOGI(TAG, "GPIO_RST=%hd", GPIO_RST);
-	if ( GPIO_RST >= 0 ) {
-		gpio_reset_pin( GPIO_RST );
-		gpio_set_direction( GPIO_RST, GPIO_MODE_OUTPUT );
-		gpio_set_level( GPIO_RST, 1 );
-	}
-
-	ESP_LOGI(TAG, "GPIO_MOSI=%hd", GPIO_MOSI);
-	ESP_LOGI(TAG, "GPIO_SCLK=%hd", GPIO_SCLK);
-	spi_bus_config_t buscfg = {
-		.mosi_io_num = GPIO_MOSI,
-		.miso_io_num = -1,
-		.sclk_io_num = GPIO_SCLK,
-		.quadwp_io_num = -1,
-		.quadhd_io_num = -1,
-		.max_transfer_sz = 0,
-		.flags = 0
-	};
-
-	ret = spi_bus_initialize( LCD_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO );
-	ESP_LOGD(TAG, "spi_bus_initialize=%d",(int)ret);
-	assert(ret==ESP_OK);
-
-	spi_device_interface_config_t devcfg;
-	memset(&devcfg, 0, sizeof(devcfg));
-	devcfg.clock_speed_hz = clock_freq_hz;
-	devcfg.queue_size = 7;
-	devcfg.mode = 3;
-	devcfg.flags = SPI_DEVICE_NO_DUMMY;
-
-	if ( GPIO_CS >= 0 ) {
-		devcfg.spics_io_num = GPIO_CS;
-	} else {
-		devcfg.spics_io_num = -1;
-	}
-
-	spi_device_handle_t handle;
-	ret = spi_bus_add_device( LCD_SPI_HOST, &devcfg, &handle);
-	ESP_LOGD(TAG, "spi_bus_add_device=%d",(int)ret);
-	assert(ret==ESP_OK);
-	dev->res = GPIO_RST;
-	dev->dc = GPIO_DC;
-	dev->bl = GPIO_BL;
-	dev->SPIHandle = handle;
-}
-
-static bool spi_master_write_bytes(spi_device_handle_t SPIHandle, const uint8_t* Data, size_t DataLength)
-{
-	spi_transaction_t SPITransaction;
-	esp_err_t ret;
-
-	if ( DataLength > 0 ) {
-		memset( &SPITransaction, 0, sizeof( spi_transaction_t ) );
-		SPITransaction.length = DataLength * 8;
-		SPITransaction.tx_buffer = Data;
-#if 0
-		ret = spi_device_transmit( SPIHandle, &SPITransaction );
-#else
-		ret = spi_device_polling_transmit( SPIHandle, &SPITransaction );
-#endif
-		assert(ret==ESP_OK);
-	}
-
-	return true;
-}
-
-static bool spi_master_write_command(TFT_t *dev, uint8_t cmd)
+static void write_command(uint8_t cmd)
 {
-	static uint8_t Byte = 0;
-	Byte = cmd;
-	gpio_set_level( dev->dc, SPI_Command_Mode );
-	return spi_master_write_bytes( dev->SPIHandle, &Byte, 1 );
+	lcd_io_command(cmd);
 }
 
-static bool spi_master_write_data_byte(TFT_t *dev, uint8_t data)
+static void write_data_byte(uint8_t data)
 {
 	static uint8_t Byte = 0;
 	Byte = data;
-	gpio_set_level( dev->dc, SPI_Data_Mode );
-	return spi_master_write_bytes( dev->SPIHandle, &Byte, 1 );
-}
-
-#if 0
-static bool spi_master_write_data_word(TFT_t *dev, uint16_t data)
-{
-	static uint8_t Byte[2];
-	Byte[0] = (data >> 8) & 0xFF;
-	Byte[1] = data & 0xFF;
-	gpio_set_level( dev->dc, SPI_Data_Mode );
-	return spi_master_write_bytes( dev->SPIHandle, Byte, 2);
+	lcd_io_data(&Byte, 1);
 }
-#endif
 
-static bool spi_master_write_addr(TFT_t *dev, uint16_t addr1, uint16_t addr2)
+static void write_addr(uint16_t addr1, uint16_t addr2)
 {
 	static uint8_t Byte[4];
 	Byte[0] = (addr1 >> 8) & 0xFF;
 	Byte[1] = addr1 & 0xFF;
 	Byte[2] = (addr2 >> 8) & 0xFF;
 	Byte[3] = addr2 & 0xFF;
-	gpio_set_level( dev->dc, SPI_Data_Mode );
-	return spi_master_write_bytes( dev->SPIHandle, Byte, 4);
+	lcd_io_data(Byte, 4);
+}
+
+// Pixels per bounce buffer in RGB444, kept even so pairs don't split.
+#define BUF_LEN_444 ((BUF_LEN*2/3) & ~1)
+
+// Reduce an RGB565 color to RGB444.
+#define RGB444(c) ((((c) >> 4) & 0xF00) | (((c) >> 3) & 0x0F0) | (((c) >> 1) & 0x00F))
+
+// Bytes on the bus for n RGB444 pixels. An odd last pixel takes two bytes.
+#define BYTES_444(n) ((n)/2*3 + ((n)&1)*2)
+
+// Pack n colors as RGB444, two pixels in three bytes.
+static void pack_444(uint8_t *buf, const color_t *colors, size_t n)
+{
+	size_t i;
+	for (i = 0; i+1 < n; i += 2) {
+		uint16_t c0 = RGB444(colors[i]);
+		uint16_t c1 = RGB444(colors[i+1]);
+		*buf++ = c0 >> 4;
+		*buf++ = (c0 << 4) | (c1 >> 8);
+		*buf++ = c1;
+	}
+	if (i < n) {
+		uint16_t c0 = RGB444(colors[i]);
+		*buf++ = c0 >> 4;
+		*buf++ = c0 << 4;
+	}
 }
 
 // size is number of color elements, not bytes.
-inline static bool spi_master_write_color(TFT_t *dev, color_t color, size_t size)
+inline static void write_color(color_t color, size_t size)
 {
+	if (dev->pixel_format == FORMAT_RGB444) {
+		uint16_t c = RGB444(color);
+		uint8_t *p = (uint8_t *)buffer;
+		size_t n = (size < BUF_LEN_444) ? size : BUF_LEN_444;
+		for (size_t i = 0; i < n; i += 2) {
+			*p++ = c >> 4;
+			*p++ = (c << 4) | (c >> 8);
+			*p++ = c;
+		}
+		while (size) {
+			n = (size < BUF_LEN_444) ? size : BUF_LEN_444;
+			lcd_io_data((uint8_t *)buffer, BYTES_444(n));
+			size -= n;
+		}
+		return;
+	}
 	uint16_t temp = SWAP16(color);
 	size_t n = (size < BUF_LEN) ? size : BUF_LEN;
 	for (size_t i = 0; i < n; i++) buffer[i] = temp;
-	gpio_set_level(dev->dc, SPI_Data_Mode);
 	while (size) {
 		n = (size < BUF_LEN) ? size : BUF_LEN;
-		spi_master_write_bytes(dev->SPIHandle, (uint8_t *)buffer, n*sizeof(uint16_t));
+		lcd_io_data((uint8_t *)buffer, n*sizeof(uint16_t));
 		size -= n;
 	}
-	return true;
 }
 
 // size is number of color elements, not bytes.
-inline static bool spi_master_write_colors(TFT_t *dev, const color_t *colors, size_t size)
+inline static void write_colors(const color_t *colors, size_t size)
 {
-	gpio_set_level(dev->dc, SPI_Data_Mode);
+	if (dev->pixel_format == FORMAT_RGB444) {
+		while (size) {
+			size_t n = (size < BUF_LEN_444) ? size : BUF_LEN_444;
+			pack_444((uint8_t *)buffer, colors, n);
+			lcd_io_data((uint8_t *)buffer, BYTES_444(n));
+			colors += n;
+			size -= n;
+		}
+		return;
+	}
 	while (size) {
 		size_t n = (size < BUF_LEN) ? size : BUF_LEN;
 		for (size_t i = 0; i < n; i++) buffer[i] = SWAP16(colors[i]);
-		spi_master_write_bytes(dev->SPIHandle, (uint8_t *)buffer, n*sizeof(uint16_t));
+		lcd_io_data((uint8_t *)buffer, n*sizeof(uint16_t));
 		colors += n;
 		size -= n;
 	}
-	return true;
 }
 
 
@@ -247,20 +177,7 @@ inline static bool spi_master_write_colors(TFT_t *dev, const color_t *colors, si
 
 void lcd_init(void)
 {
-	spi_master_init(dev,
-		LCD_MOSI,
-		LCD_SCLK,
-		LCD_CS,
-		LCD_DC,
-		LCD_RST,
-		LCD_BL);
-
-	if (dev->res >= 0) {
-		gpio_set_level(dev->res, 0);
-		delayMS(20);
-		gpio_set_level(dev->res, 1);
-		delayMS(120);
-	}
+	lcd_io_init();
 
 	dev->width = LCD_W;
 	dev->height = LCD_H;
@@ -272,140 +189,143 @@ void lcd_init(void)
 	dev->font_back_color = BLACK;
 	dev->use_frame_buffer = false;
 	dev->frame_buffer = NULL;
+	dev->present_mode = PRESENT_FULL;
+	dev->pixel_format = FORMAT_RGB565;
+	dev->field = 0;
 
 #if LCD_DRIVER == 0
-	// spi_master_write_command(dev, 0x01);    // ILI:Software Reset (01h), ST:SWRESET (01h): Software Reset
+	// write_command(0x01);    // ILI:Software Reset (01h), ST:SWRESET (01h): Software Reset
 	// delayMS(5);
 
-	spi_master_write_command(dev, 0x3A);    // ILI:COLMOD: Pixel Format Set (3Ah), ST:COLMOD (3Ah): Interface Pixel Format
-	spi_master_write_data_byte(dev, 0x55);
+	write_command(0x3A);    // ILI:COLMOD: Pixel Format Set (3Ah), ST:COLMOD (3Ah): Interface Pixel Format
+	write_data_byte(COLMOD_RGB565);
 	// delayMS(10);
 
-	spi_master_write_command(dev, 0x36);    // ILI:Memory Access Control (36h), ST:MADCTL (36h): Memory Data Access Control
-	spi_master_write_data_byte(dev, 0x08);  // 0x00
-
-	spi_master_write_command(dev, 0xCF);    // ILI:Power control B (CFh), ILI9341 only
-	spi_master_write_data_byte(dev, 0x00);
-	spi_master_write_data_byte(dev, 0xc3);
-	spi_master_write_data_byte(dev, 0x30);
-	spi_master_write_command(dev, 0xED);    // ILI:Power on sequence control (EDh), ILI9341 only
-	spi_master_write_data_byte(dev, 0x64);
-	spi_master_write_data_byte(dev, 0x03);
-	spi_master_write_data_byte(dev, 0x12);
-	spi_master_write_data_byte(dev, 0x81);
-	spi_master_write_command(dev, 0xE8);    // ILI:Driver timing control A (E8h), ST:PWCTRL2 (E8h): Power Control 2
-	spi_master_write_data_byte(dev, 0x85);
-	spi_master_write_data_byte(dev, 0x00);
-	spi_master_write_data_byte(dev, 0x78);
-	spi_master_write_command(dev, 0xCB);    // ILI:Power control A (CBh), ILI9341 only
-	spi_master_write_data_byte(dev, 0x39);
-	spi_master_write_data_byte(dev, 0x2c);
-	spi_master_write_data_byte(dev, 0x00);
-	spi_master_write_data_byte(dev, 0x34);
-	spi_master_write_data_byte(dev, 0x02);
-	spi_master_write_command(dev, 0xF7);    // ILI:Pump ratio control (F7h), ILI9341 only
-	spi_master_write_data_byte(dev, 0x20);
-	spi_master_write_command(dev, 0xEA);    // ILI:Driver timing control B (EAh), ILI9341 only
-	spi_master_write_data_byte(dev, 0x00);
-	spi_master_write_data_byte(dev, 0x00);
-	spi_master_write_command(dev, 0xC0);    // ILI:Power Control 1 (C0h), ST:LCMCTRL (C0h): LCM Control
-	spi_master_write_data_byte(dev, 0x1B);
-	spi_master_write_command(dev, 0xC1);    // ILI:Power Control 2 (C1h), ST:IDSET (C1h): ID Code Setting
-	spi_master_write_data_byte(dev, 0x12);
-	spi_master_write_command(dev, 0xC5);    // ILI:VCOM Control 1(C5h), ST:VCMOFSET (C5h): VCOM Offset Set
-	spi_master_write_data_byte(dev, 0x32);
-	spi_master_write_data_byte(dev, 0x3C);
-	spi_master_write_command(dev, 0xC7);    // ILI:VCOM Control 2(C7h), ST:CABCCTRL (C7h): CABC Control
-	spi_master_write_data_byte(dev, 0x91);
-	spi_master_write_command(dev, 0xB1);    // ILI:Frame Rate Control (In Normal Mode/Full Colors) (B1h), ST:RGBCTRL (B1h): RGB Interface Control
-	spi_master_write_data_byte(dev, 0x00);
-	spi_master_write_data_byte(dev, 0x10);
-	spi_master_write_command(dev, 0xB6);    // ILI:Display Function Control (B6h), ILI9341 only
-	spi_master_write_data_byte(dev, 0x0A);
-	spi_master_write_data_byte(dev, 0xA2);
-	spi_master_write_command(dev, 0xF6);    // ILI:Interface Control (F6h), ILI9341 only
-	spi_master_write_data_byte(dev, 0x01);
-	spi_master_write_data_byte(dev, 0x30);
-
-	spi_master_write_command(dev, 0x11);    // ILI:Sleep Out (11h), ST:SLPOUT (11h): Sleep Out
+	write_command(0x36);    // ILI:Memory Access Control (36h), ST:MADCTL (36h): Memory Data Access Control
+	write_data_byte(0x08);  // 0x00
+
+	write_command(0xCF);    // ILI:Power control B (CFh), ILI9341 only
+	write_data_byte(0x00);
+	write_data_byte(0xc3);
+	write_data_byte(0x30);
+	write_command(0xED);    // ILI:Power on sequence control (EDh), ILI9341 only
+	write_data_byte(0x64);
+	write_data_byte(0x03);
+	write_data_byte(0x12);
+	write_data_byte(0x81);
+	write_command(0xE8);    // ILI:Driver timing control A (E8h), ST:PWCTRL2 (E8h): Power Control 2
+	write_data_byte(0x85);
+	write_data_byte(0x00);
+	write_data_byte(0x78);
+	write_command(0xCB);    // ILI:Power control A (CBh), ILI9341 only
+	write_data_byte(0x39);
+	write_data_byte(0x2c);
+	write_data_byte(0x00);
+	write_data_byte(0x34);
+	write_data_byte(0x02);
+	write_command(0xF7);    // ILI:Pump ratio control (F7h), ILI9341 only
+	write_data_byte(0x20);
+	write_command(0xEA);    // ILI:Driver timing control B (EAh), ILI9341 only
+	write_data_byte(0x00);
+	write_data_byte(0x00);
+	write_command(0xC0);    // ILI:Power Control 1 (C0h), ST:LCMCTRL (C0h): LCM Control
+	write_data_byte(0x1B);
+	write_command(0xC1);    // ILI:Power Control 2 (C1h), ST:IDSET (C1h): ID Code Setting
+	write_data_byte(0x12);
+	write_command(0xC5);    // ILI:VCOM Control 1(C5h), ST:VCMOFSET (C5h): VCOM Offset Set
+	write_data_byte(0x32);
+	write_data_byte(0x3C);
+	write_command(0xC7);    // ILI:VCOM Control 2(C7h), ST:CABCCTRL (C7h): CABC Control
+	write_data_byte(0x91);
+	write_command(0xB1);    // ILI:Frame Rate Control (In Normal Mode/Full Colors) (B1h), ST:RGBCTRL (B1h): RGB Interface Control
+	write_data_byte(0x00);
+	write_data_byte(0x10);
+	write_command(0xB6);    // ILI:Display Function Control (B6h), ILI9341 only
+	write_data_byte(0x0A);
+	write_data_byte(0xA2);
+	write_command(0xF6);    // ILI:Interface Control (F6h), ILI9341 only
+	write_data_byte(0x01);
+	write_data_byte(0x30);
+
+	write_command(0x11);    // ILI:Sleep Out (11h), ST:SLPOUT (11h): Sleep Out
 	delayMS(5);
 
 #elif LCD_DRIVER == 1
 
-	// spi_master_write_command(dev, 0x01);  // SWRESET (01h): Software Reset
+	// write_command(0x01);  // SWRESET (01h): Software Reset
 	// delayMS(5);
 
-	spi_master_write_command(dev, 0x36);  // MADCTL (36h): Memory Data Access Control
-	spi_master_write_data_byte(dev, 0x00);
-
-	spi_master_write_command(dev, 0x3A);  // COLMOD (3Ah): Interface Pixel Format
-	spi_master_write_data_byte(dev, 0x05);
-
-	spi_master_write_command(dev, 0xB2);  // PORCTRL (B2h): Porch Setting
-	spi_master_write_data_byte(dev, 0x0C);
-	spi_master_write_data_byte(dev, 0x0C);
-	spi_master_write_data_byte(dev, 0x00);
-	spi_master_write_data_byte(dev, 0x33);
-	spi_master_write_data_byte(dev, 0x33);
-
-	spi_master_write_command(dev, 0xB7);  // GCTRL (B7h): Gate Control
-	spi_master_write_data_byte(dev, 0x35);
-
-	spi_master_write_command(dev, 0xBB);  // VCOMS (BBh): VCOM Setting
-	spi_master_write_data_byte(dev, 0x19);
-
-	spi_master_write_command(dev, 0xC0);  // LCMCTRL (C0h): LCM Control
-	spi_master_write_data_byte(dev, 0x2C);
-
-	spi_master_write_command(dev, 0xC2);  // VDVVRHEN (C2h): VDV and VRH Command Enable
-	spi_master_write_data_byte(dev, 0x01);
-
-	spi_master_write_command(dev, 0xC3);  // VRHS (C3h): VRH Set
-	spi_master_write_data_byte(dev, 0x12);
-
-	spi_master_write_command(dev, 0xC4);  // VDVS (C4h): VDV Set
-	spi_master_write_data_byte(dev, 0x20);
-
-	spi_master_write_command(dev, 0xC6);  // FRCTRL2 (C6h): Frame Rate Control in Normal Mode
-	spi_master_write_data_byte(dev, 0x0F);
-
-	spi_master_write_command(dev, 0xD0);  // PWCTRL1 (D0h): Power Control 1
-	spi_master_write_data_byte(dev, 0xA4);
-	spi_master_write_data_byte(dev, 0xA1);
-
-	spi_master_write_command(dev, 0xE0);  // PVGAMCTRL (E0h): Positive Voltage Gamma Control
-	spi_master_write_data_byte(dev, 0xD0);
-	spi_master_write_data_byte(dev, 0x04);
-	spi_master_write_data_byte(dev, 0x0D);
-	spi_master_write_data_byte(dev, 0x11);
-	spi_master_write_data_byte(dev, 0x13);
-	spi_master_write_data_byte(dev, 0x2B);
-	spi_master_write_data_byte(dev, 0x3F);
-	spi_master_write_data_byte(dev, 0x54);
-	spi_master_write_data_byte(dev, 0x4C);
-	spi_master_write_data_byte(dev, 0x18);
-	spi_master_write_data_byte(dev, 0x0D);
-	spi_master_write_data_byte(dev, 0x0B);
-	spi_master_write_data_byte(dev, 0x1F);
-	spi_master_write_data_byte(dev, 0x23);
-
-	spi_master_write_command(dev, 0xE1);  // NVGAMCTRL (E1h): Negative Voltage Gamma Control
-	spi_master_write_data_byte(dev, 0xD0);
-	spi_master_write_data_byte(dev, 0x04);
-	spi_master_write_data_byte(dev, 0x0C);
-	spi_master_write_data_byte(dev, 0x11);
-	spi_master_write_data_byte(dev, 0x13);
-	spi_master_write_data_byte(dev, 0x2C);
-	spi_master_write_data_byte(dev, 0x3F);
-	spi_master_write_data_byte(dev, 0x44);
-	spi_master_write_data_byte(dev, 0x51);
-	spi_master_write_data_byte(dev, 0x2F);
-	spi_master_write_data_byte(dev, 0x1F);
-	spi_master_write_data_byte(dev, 0x1F);
-	spi_master_write_data_byte(dev, 0x20);
-	spi_master_write_data_byte(dev, 0x23);
-
-	spi_master_write_command(dev, 0x11);  // SLPOUT (11h): Sleep Out
+	write_command(0x36);  // MADCTL (36h): Memory Data Access Control
+	write_data_byte(0x00);
+
+	write_command(0x3A);  // COLMOD (3Ah): Interface Pixel Format
+	write_data_byte(COLMOD_RGB565);
+
+	write_command(0xB2);  // PORCTRL (B2h): Porch Setting
+	write_data_byte(0x0C);
+	write_data_byte(0x0C);
+	write_data_byte(0x00);
+	write_data_byte(0x33);
+	write_data_byte(0x33);
+
+	write_command(0xB7);  // GCTRL (B7h): Gate Control
+	write_data_byte(0x35);
+
+	write_command(0xBB);  // VCOMS (BBh): VCOM Setting
+	write_data_byte(0x19);
+
+	write_command(0xC0);  // LCMCTRL (C0h): LCM Control
+	write_data_byte(0x2C);
+
+	write_command(0xC2);  // VDVVRHEN (C2h): VDV and VRH Command Enable
+	write_data_byte(0x01);
+
+	write_command(0xC3);  // VRHS (C3h): VRH Set
+	write_data_byte(0x12);
+
+	write_command(0xC4);  // VDVS (C4h): VDV Set
+	write_data_byte(0x20);
+
+	write_command(0xC6);  // FRCTRL2 (C6h): Frame Rate Control in Normal Mode
+	write_data_byte(0x0F);
+
+	write_command(0xD0);  // PWCTRL1 (D0h): Power Control 1
+	write_data_byte(0xA4);
+	write_data_byte(0xA1);
+
+	write_command(0xE0);  // PVGAMCTRL (E0h): Positive Voltage Gamma Control
+	write_data_byte(0xD0);
+	write_data_byte(0x04);
+	write_data_byte(0x0D);
+	write_data_byte(0x11);
+	write_data_byte(0x13);
+	write_data_byte(0x2B);
+	write_data_byte(0x3F);
+	write_data_byte(0x54);
+	write_data_byte(0x4C);
+	write_data_byte(0x18);
+	write_data_byte(0x0D);
+	write_data_byte(0x0B);
+	write_data_byte(0x1F);
+	write_data_byte(0x23);
+
+	write_command(0xE1);  // NVGAMCTRL (E1h): Negative Voltage Gamma Control
+	write_data_byte(0xD0);
+	write_data_byte(0x04);
+	write_data_byte(0x0C);
+	write_data_byte(0x11);
+	write_data_byte(0x13);
+	write_data_byte(0x2C);
+	write_data_byte(0x3F);
+	write_data_byte(0x44);
+	write_data_byte(0x51);
+	write_data_byte(0x2F);
+	write_data_byte(0x1F);
+	write_data_byte(0x1F);
+	write_data_byte(0x20);
+	write_data_byte(0x23);
+
+	write_command(0x11);  // SLPOUT (11h): Sleep Out
 	delayMS(5);
 
 #endif
@@ -437,12 +357,12 @@ void lcd_fillScreen(color_t color)
 			ptr += n; len -= n;
 		}
 	} else {
-		spi_master_write_command(dev, 0x2A); // Column(x) Address Set
-		spi_master_write_addr(dev, 0, dev->width-1);
-		spi_master_write_command(dev, 0x2B); // Page(y) Address Set
-		spi_master_write_addr(dev, 0, dev->height-1);
-		spi_master_write_command(dev, 0x2C); // Memory Write
-		spi_master_write_color(dev, color, (size_t)dev->width*dev->height);
+		write_command(0x2A); // Column(x) Address Set
+		write_addr(0, dev->width-1);
+		write_command(0x2B); // Page(y) Address Set
+		write_addr(0, dev->height-1);
+		write_command(0x2C); // Memory Write
+		write_color(color, (size_t)dev->width*dev->height);
 	}
 }
 
@@ -457,12 +377,12 @@ void lcd_drawPixel(coord_t x, coord_t y, color_t color)
 		coord_t _x = x + dev->offsetx;
 		coord_t _y = y + dev->offsety;
 
-		spi_master_write_command(dev, 0x2A); // Column(x) Address Set
-		spi_master_write_addr(dev, _x, _x);
-		spi_master_write_command(dev, 0x2B); // Page(y) Address Set
-		spi_master_write_addr(dev, _y, _y);
-		spi_master_write_command(dev, 0x2C); // Memory Write
-		spi_master_write_colors(dev, &color, 1);
+		write_command(0x2A); // Column(x) Address Set
+		write_addr(_x, _x);
+		write_command(0x2B); // Page(y) Address Set
+		write_addr(_y, _y);
+		write_command(0x2C); // Memory Write
+		write_colors(&color, 1);
 	}
 }
 
@@ -488,12 +408,12 @@ void lcd_drawHPixels(coord_t x, coord_t y, coord_t w, const color_t *colors)
 		coord_t _y1 = y + dev->offsety;
 		coord_t _y2 = _y1;
 
-		spi_master_write_command(dev, 0x2A); // Column(x) Address Set
-		spi_master_write_addr(dev, _x1, _x2);
-		spi_master_write_command(dev, 0x2B); // Page(y) Address Set
-		spi_master_write_addr(dev, _y1, _y2);
-		spi_master_write_command(dev, 0x2C); // Memory Write
-		spi_master_write_colors(dev, colors, w);
+		write_command(0x2A); // Column(x) Address Set
+		write_addr(_x1, _x2);
+		write_command(0x2B); // Page(y) Address Set
+		write_addr(_y1, _y2);
+		write_command(0x2C); // Memory Write
+		write_colors(colors, w);
 	}
 }
 
@@ -518,12 +438,12 @@ void lcd_drawHLine(coord_t x, coord_t y, coord_t w, color_t color)
 		coord_t _y1 = y + dev->offsety;
 		coord_t _y2 = _y1;
 
-		spi_master_write_command(dev, 0x2A); // Column(x) Address Set
-		spi_master_write_addr(dev, _x1, _x2);
-		spi_master_write_command(dev, 0x2B); // Page(y) Address Set
-		spi_master_write_addr(dev, _y1, _y2);
-		spi_master_write_command(dev, 0x2C); // Memory Write
-		spi_master_write_color(dev, color, w);
+		write_command(0x2A); // Column(x) Address Set
+		write_addr(_x1, _x2);
+		write_command(0x2B); // Page(y) Address Set
+		write_addr(_y1, _y2);
+		write_command(0x2C); // Memory Write
+		write_color(color, w);
 	}
 }
 
@@ -547,12 +467,12 @@ void lcd_drawVLine(coord_t x, coord_t y, coord_t h, color_t color)
 		coord_t _y2 =  y2 + dev->offsety;
 		size_t size = _y2-_y1+1;
 
-		spi_master_write_command(dev, 0x2A); // Column(x) Address Set
-		spi_master_write_addr(dev, _x1, _x2);
-		spi_master_write_command(dev, 0x2B); // Page(y) Address Set
-		spi_master_write_addr(dev, _y1, _y2);
-		spi_master_write_command(dev, 0x2C); // Memory Write
-		spi_master_write_color(dev, color, size);
+		write_command(0x2A); // Column(x) Address Set
+		write_addr(_x1, _x2);
+		write_command(0x2B); // Page(y) Address Set
+		write_addr(_y1, _y2);
+		write_command(0x2C); // Memory Write
+		write_color(color, size);
 	}
 }
 
@@ -645,12 +565,12 @@ void lcd_fillRect(coord_t x, coord_t y, coord_t w, coord_t h, color_t color)
 		coord_t _y1 = y1 + dev->offsety;
 		size_t size = (size_t)(_x1-_x0+1)*(_y1-_y0+1);
 
-		spi_master_write_command(dev, 0x2A); // Column(x) Address Set
-		spi_master_write_addr(dev, _x0, _x1);
-		spi_master_write_command(dev, 0x2B); // Page(y) Address Set
-		spi_master_write_addr(dev, _y0, _y1);
-		spi_master_write_command(dev, 0x2C); // Memory Write
-		spi_master_write_color(dev, color, size);
+		write_command(0x2A); // Column(x) Address Set
+		write_addr(_x0, _x1);
+		write_command(0x2B); // Page(y) Address Set
+		write_addr(_y0, _y1);
+		write_command(0x2C); // Memory Write
+		write_color(color, size);
 	}
 }
 
@@ -918,6 +838,43 @@ void lcd_drawRGBBitmap(coord_t x, coord_t y, const color_t *bitmap, coord_t w, c
 	}
 }
 
+/**
+ * @note Packets may span rows, so each one is split into row segments.
+ *  Segments are clipped by lcd_drawHLine() and lcd_drawHPixels().
+ */
+void lcd_drawImageRLE(coord_t x, coord_t y, const uint16_t *rle, coord_t w, coord_t h)
+{
+	if (w <= 0 || h <= 0) return; // empty
+	if (x+w <= 0 || x >= dev->width) return; // off screen
+	if (y+h <= 0 || y >= dev->height) return;
+
+	coord_t col = 0, row = 0;
+	while (row < h) {
+		uint16_t hdr = *rle++;
+		coord_t cnt = hdr & LCD_RLE_CNT;
+		bool run = hdr & LCD_RLE_RUN;
+		color_t color = run ? *rle++ : 0;
+		while (cnt && row < h) {
+			coord_t n = (cnt < w-col) ? cnt : w-col;
+			if (y+row >= dev->height) return; // rest is off screen
+			// Clip the segment to the left and right edges. Rows above
+			// the top are decoded but not drawn.
+			coord_t sx = x+col;
+			coord_t skip = (sx < 0) ? -sx : 0;
+			coord_t len = n - skip;
+			if (sx+n > dev->width) len -= sx+n - dev->width;
+			if (len > 0 && y+row >= 0) {
+				if (run) lcd_drawHLine(sx+skip, y+row, len, color);
+				else lcd_drawHPixels(sx+skip, y+row, len, rle+skip);
+			}
+			if (!run) rle += n;
+			cnt -= n;
+			col += n;
+			if (col == w) {col = 0; row++;}
+		}
+	}
+}
+
 //----------------------------------------------------------------------------//
 // Rectangle variants that specify two diagonal corners
 //----------------------------------------------------------------------------//
@@ -959,12 +916,12 @@ void lcd_fillRect2(coord_t x0, coord_t y0, coord_t x1, coord_t y1, color_t color
 		coord_t _y1 = y1 + dev->offsety;
 		size_t size = (size_t)(_x1-_x0+1)*(_y1-_y0+1);
 
-		spi_master_write_command(dev, 0x2A); // Column(x) Address Set
-		spi_master_write_addr(dev, _x0, _x1);
-		spi_master_write_command(dev, 0x2B); // Page(y) Address Set
-		spi_master_write_addr(dev, _y0, _y1);
-		spi_master_write_command(dev, 0x2C); // Memory Write
-		spi_master_write_color(dev, color, size);
+		write_command(0x2A); // Column(x) Address Set
+		write_addr(_x0, _x1);
+		write_command(0x2B); // Page(y) Address Set
+		write_addr(_y0, _y1);
+		write_command(0x2C); // Memory Write
+		write_color(color, size);
 	}
 }
 
@@ -1228,41 +1185,59 @@ void lcd_noFontBackground(void)
 void lcd_spiClockFreq(int32_t freq)
 {
 	ESP_LOGI(TAG, "SPI clock frequency=%d MHz", (int)freq/1000000);
-	clock_freq_hz = freq;
+	lcd_io_clockFreq(freq);
 }
 
 void lcd_displayOff(void)
 {
-	spi_master_write_command(dev, 0x28); // Display OFF (28h), DISPOFF (28h): Display Off
+	write_command(0x28); // Display OFF (28h), DISPOFF (28h): Display Off
 }
 
 void lcd_displayOn(void)
 {
-	spi_master_write_command(dev, 0x29); // Display ON (29h), DISPON (29h): Display On
+	write_command(0x29); // Display ON (29h), DISPON (29h): Display On
 }
 
 void lcd_backlightOff(void)
 {
-	if (dev->bl >= 0) {
-		gpio_set_level(dev->bl, 0);
-	}
+	lcd_io_backlight(false);
 }
 
 void lcd_backlightOn(void)
 {
-	if (dev->bl >= 0) {
-		gpio_set_level(dev->bl, 1);
-	}
+	lcd_io_backlight(true);
 }
 
 void lcd_inversionOff(void)
 {
-	spi_master_write_command(dev, 0x20); // Display Inversion OFF (20h), INVOFF (20h): Display Inversion Off
+	write_command(0x20); // Display Inversion OFF (20h), INVOFF (20h): Display Inversion Off
 }
 
 void lcd_inversionOn(void)
 {
-	spi_master_write_command(dev, 0x21); // Display Inversion ON (21h), INVON (21h): Display Inversion On
+	write_command(0x21); // Display Inversion ON (21h), INVON (21h): Display Inversion On
+}
+
+void lcd_setPixelFormat(format_t format)
+{
+#if LCD_DRIVER == 0
+	if (format == FORMAT_RGB444) {
+		ESP_LOGW(TAG, "RGB444 not supported by driver, using RGB565");
+		format = FORMAT_RGB565;
+	}
+#endif
+	dev->pixel_format = format;
+	write_command(0x3A); // ILI:COLMOD: Pixel Format Set (3Ah), ST:COLMOD (3Ah): Interface Pixel Format
+#if LCD_DRIVER == 0
+	write_data_byte(COLMOD_RGB565);
+#else
+	write_data_byte((format == FORMAT_RGB444) ? COLMOD_RGB444 : COLMOD_RGB565);
+#endif
+}
+
+format_t lcd_getPixelFormat(void)
+{
+	return dev->pixel_format;
 }
 
 //----------------------------------------------------------------------------//
@@ -1272,7 +1247,7 @@ void lcd_inversionOn(void)
 void lcd_frameEnable(void)
 {
 	if (dev->use_frame_buffer == true) return;
-	dev->frame_buffer = heap_caps_malloc(sizeof(color_t)*dev->width*dev->height, MALLOC_CAP_DMA);
+	dev->frame_buffer = lcd_io_alloc(sizeof(color_t)*dev->width*dev->height);
 	if (dev->frame_buffer == NULL) {
 		ESP_LOGE(TAG, "frame buffer alloc fail");
 	} else {
@@ -1283,7 +1258,7 @@ void lcd_frameEnable(void)
 
 void lcd_frameDisable(void)
 {
-	if (dev->frame_buffer != NULL) heap_caps_free(dev->frame_buffer);
+	if (dev->frame_buffer != NULL) lcd_io_free(dev->frame_buffer);
 	dev->frame_buffer = NULL;
 	dev->use_frame_buffer = false;
 }
@@ -1356,12 +1331,23 @@ void lcd_writeFrame(void)
 {
 	if (dev->use_frame_buffer == false) return;
 
-	spi_master_write_command(dev, 0x2A); // Column(x) Address Set
-	spi_master_write_addr(dev, dev->offsetx, dev->offsetx+dev->width-1);
-	spi_master_write_command(dev, 0x2B); // Page(y) Address Set
-	spi_master_write_addr(dev, dev->offsety, dev->offsety+dev->height-1);
-	spi_master_write_command(dev, 0x2C); // Memory Write
-	spi_master_write_colors(dev, dev->frame_buffer, dev->width*dev->height);
+	write_command(0x2A); // Column(x) Address Set
+	write_addr(dev->offsetx, dev->offsetx+dev->width-1);
+	if (dev->present_mode == PRESENT_INTERLACED) {
+		// One row window per line of the field. The column window is kept.
+		for (coord_t y = dev->field; y < dev->height; y += 2) {
+			write_command(0x2B); // Page(y) Address Set
+			write_addr(dev->offsety+y, dev->offsety+y);
+			write_command(0x2C); // Memory Write
+			write_colors(dev->frame_buffer+(size_t)y*dev->width, dev->width);
+		}
+		dev->field ^= 1;
+		return;
+	}
+	write_command(0x2B); // Page(y) Address Set
+	write_addr(dev->offsety, dev->offsety+dev->height-1);
+	write_command(0x2C); // Memory Write
+	write_colors(dev->frame_buffer, dev->width*dev->height);
 
 #if 0
 	size_t size = (size_t)dev->width*dev->height;
@@ -1369,10 +1355,50 @@ void lcd_writeFrame(void)
 	while (size > 0) {
 		// 1024 bytes per time.
 		size_t bs = (size > 512) ? 512 : size;
-		spi_master_write_colors(dev, image, bs);
+		write_colors(image, bs);
 		size -= bs;
 		image += bs;
 	}
 #endif
 	return;
 }
+
+void lcd_writeFrameRect(coord_t x, coord_t y, coord_t w, coord_t h)
+{
+	if (dev->use_frame_buffer == false) return;
+
+	if (x < 0) {w += x; x = 0;} // clip
+	if (y < 0) {h += y; y = 0;}
+	if (x+w > dev->width) w = dev->width-x;
+	if (y+h > dev->height) h = dev->height-y;
+	if (w <= 0 || h <= 0) return;
+	if (dev->pixel_format == FORMAT_RGB444 && (w & 1)) {
+		// Pixel pairs must not span rows
+		if (x+w < dev->width) w++;
+		else if (x > 0) {x--; w++;}
+	}
+
+	write_command(0x2A); // Column(x) Address Set
+	write_addr(dev->offsetx+x, dev->offsetx+x+w-1);
+	write_command(0x2B); // Page(y) Address Set
+	write_addr(dev->offsety+y, dev->offsety+y+h-1);
+	write_command(0x2C); // Memory Write
+	color_t *row = dev->frame_buffer+(size_t)y*dev->width+x;
+	if (w == dev->width) {
+		write_colors(row, (size_t)w*h);
+	} else {
+		for (coord_t i = 0; i < h; i++, row += dev->width)
+			write_colors(row, w);
+	}
+}
+
+void lcd_setPresentMode(present_t mode)
+{
+	dev->present_mode = mode;
+	dev->field = 0;
+}
+
+present_t lcd_getPresentMode(void)
+{
+	return dev->present_mode;
+}
@@ -47,6 +47,13 @@
 
 /** @} */
 
+/** @name Run-length encoded image packet header fields. */
+/** @{ */
+#define LCD_RLE_RUN 0x8000 // Next word is a color repeated count times
+#define LCD_RLE_CNT 0x7FFF // Count of pixels in the packet
+
+/** @} */
+
 /** @brief Coordinate type for x,y screen positions. */
 /** @note Needs to be signed to handle off screen positions. */
 typedef int32_t coord_t;
@@ -74,6 +81,18 @@ typedef enum {
 	SCROLL_UP = 4,
 } scroll_t;
 
+/** @brief Present type for how lcd_writeFrame() sends the frame buffer. */
+typedef enum {
+	PRESENT_FULL,       ///< All rows every frame.
+	PRESENT_INTERLACED, ///< Even rows on one frame, odd rows on the next.
+} present_t;
+
+/** @brief Pixel format used on the bus to the display. */
+typedef enum {
+	FORMAT_RGB565, ///< 16 bits per pixel.
+	FORMAT_RGB444, ///< 12 bits per pixel, two pixels in three bytes.
+} format_t;
+
 /**
  * @brief Initialize the LCD module.
  */
@@ -263,6 +282,24 @@ void lcd_drawBitmap(coord_t x, coord_t y, const uint8_t *bitmap, coord_t w, coor
  */
 void lcd_drawRGBBitmap(coord_t x, coord_t y, const color_t *bitmap, coord_t w, coord_t h);
 
+/**
+ * @brief Draw a run-length encoded image at the specified location.
+ * @param x   Top left corner X coordinate.
+ * @param y   Top left corner Y coordinate.
+ * @param rle Array of RLE packets that decode to w * h color values.
+ * @param w   Width of image in pixels.
+ * @param h   Height of image in pixels.
+ * @details The image is a sequence of packets, each starting with a
+ *  header word. If LCD_RLE_RUN is set in the header, the next word is a
+ *  color repeated (header & LCD_RLE_CNT) times. Otherwise, the header is
+ *  followed by (header & LCD_RLE_CNT) literal color values. Packets are in
+ *  row-major order and may span rows. Runs are drawn as horizontal line
+ *  fills, so flat images draw faster than with lcd_drawRGBBitmap().
+ *  The image is clipped to the screen on every edge.
+ *  Use image/image2c_rle.m to convert an image to this format.
+ */
+void lcd_drawImageRLE(coord_t x, coord_t y, const uint16_t *rle, coord_t w, coord_t h);
+
 /** @} */
 
 /** @name Rectangle variants that specify two diagonal corners. */
@@ -443,6 +480,22 @@ void lcd_inversionOff(void);
  */
 void lcd_inversionOn(void);
 
+/**
+ * @brief Set the pixel format used on the bus to the display.
+ * @param format Pixel format.
+ * @details Drawing and the frame buffer stay in RGB565. With FORMAT_RGB444,
+ *  colors are reduced to 4 bits per channel as they are sent, which cuts
+ *  the bytes per pixel by 25%. The ILI9341 has no 12-bit serial format, so
+ *  that driver keeps RGB565 and logs a warning.
+ */
+void lcd_setPixelFormat(format_t format);
+
+/**
+ * @brief Get the pixel format used on the bus to the display.
+ * @returns The pixel format.
+ */
+format_t lcd_getPixelFormat(void);
+
 /** @} */
 
 /** @name Frame management. */
@@ -475,9 +528,43 @@ void lcd_wrapAround(scroll_t scroll, coord_t start, coord_t end);
 
 /**
  * @brief Write frame buffer to display. Requires frame buffer to be enabled.
+ * @details In interlaced present mode, only every other row is sent, with
+ *  even and odd rows alternating between calls.
  */
 void lcd_writeFrame(void);
 
+/**
+ * @brief Write a rectangle of the frame buffer to display.
+ *  Requires frame buffer to be enabled.
+ * @param x Top left corner X coordinate.
+ * @param y Top left corner Y coordinate.
+ * @param w Width of rectangle.
+ * @param h Height of rectangle.
+ * @details Use to present only the part of the frame that changed. The
+ *  rectangle is clipped to the screen. All rows of the rectangle are sent
+ *  regardless of the present mode. In RGB444 format, an odd width is
+ *  widened by one pixel so rows pack into whole bytes.
+ */
+void lcd_writeFrameRect(coord_t x, coord_t y, coord_t w, coord_t h);
+
+/**
+ * @brief Set how lcd_writeFrame() sends the frame buffer to the display.
+ * @param mode Present mode.
+ * @details PRESENT_INTERLACED halves the bus traffic per frame, so frames
+ *  can be presented at twice the rate for the same SPI bandwidth. Each row
+ *  is updated at half that rate, which suits small fast-moving objects
+ *  drawn over a mostly static background. Each row is sent in its own
+ *  one-row address window. The next frame after a mode change starts
+ *  with the even rows.
+ */
+void lcd_setPresentMode(present_t mode);
+
+/**
+ * @brief Get the present mode.
+ * @returns The present mode.
+ */
+present_t lcd_getPresentMode(void);
+
 /** @} */
 
 #endif // LCD_H_
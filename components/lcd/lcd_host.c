@@ -0,0 +1,215 @@
+// Host (Linux) transport for the LCD rasterizer (lcd.c).
+// Bytes that would go out on the SPI bus are decoded by a virtual panel
+// that implements the subset of the ILI9341/ST7789 command set used by
+// the rasterizer: column/page address set, memory write and pixel format.
+
+#include <stdio.h>
+#include <stdlib.h> // malloc, free
+#include <string.h> // memset
+
+#include "hw.h"
+#include "lcd.h"
+#include "lcd_io.h"
+#include "lcd_host.h"
+
+#define CMD_CASET  0x2A // Column Address Set
+#define CMD_PASET  0x2B // Page Address Set
+#define CMD_RAMWR  0x2C // Memory Write
+#define CMD_RAMWRC 0x3C // Memory Write Continue
+#define CMD_COLMOD 0x3A // Pixel Format Set
+
+#define FNV_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+static color_t panel[LCD_W*LCD_H]; // Display memory
+static lcd_host_stats_t stats;
+
+// Decoder state
+static uint8_t  cmd;       // Last command
+static uint8_t  param[4];  // Command parameters
+static uint32_t nparam;    // Count of parameter bytes received
+static uint16_t xs, xe;    // Column window (panel coordinates)
+static uint16_t ys, ye;    // Page window (panel coordinates)
+static uint16_t cx, cy;    // Memory write position
+static uint8_t  part[3];   // Partial pixel bytes
+static uint32_t npart;     // Count of partial pixel bytes
+static uint32_t bpp = 16;  // Interface bits per pixel (16 or 12)
+
+
+static void panel_pixel(color_t c)
+{
+	int32_t x = (int32_t)cx - HW_LCD_OFFSETX;
+	int32_t y = (int32_t)cy - HW_LCD_OFFSETY;
+	if (x >= 0 && x < LCD_W && y >= 0 && y < LCD_H)
+		panel[y*LCD_W+x] = c;
+	stats.pixels++;
+	// Advance through the window like the controller, wrapping at the end.
+	if (++cx > xe) {
+		cx = xs;
+		if (++cy > ye) cy = ys;
+	}
+}
+
+// Expand a 4-bit color channel to n bits by repeating the high bits.
+#define EXP4(v, n) ((v) << ((n)-4) | (v) >> (8-(n)))
+
+static color_t rgb444_to_565(uint16_t c)
+{
+	uint16_t r = (c >> 8) & 0xF, g = (c >> 4) & 0xF, b = c & 0xF;
+	return EXP4(r, 5) << 11 | EXP4(g, 6) << 5 | EXP4(b, 5);
+}
+
+static void panel_data(uint8_t d)
+{
+	switch (cmd) {
+	case CMD_CASET:
+	case CMD_PASET:
+		if (nparam < 4) param[nparam++] = d;
+		if (nparam == 4) {
+			uint16_t a = param[0] << 8 | param[1];
+			uint16_t b = param[2] << 8 | param[3];
+			if (cmd == CMD_CASET) {xs = a; xe = b;}
+			else {ys = a; ye = b;}
+			nparam++;
+		}
+		break;
+	case CMD_RAMWR:
+	case CMD_RAMWRC:
+		part[npart++] = d;
+		if (bpp == 16 && npart == 2) {
+			panel_pixel(part[0] << 8 | part[1]);
+			npart = 0;
+		} else if (bpp == 12 && npart == 2) {
+			// Two pixels packed as R0G0 B0R1 G1B1. The first pixel is
+			// written once its 12 bits are in, so an odd last pixel
+			// can be sent in two bytes.
+			panel_pixel(rgb444_to_565(part[0] << 4 | part[1] >> 4));
+		} else if (bpp == 12 && npart == 3) {
+			panel_pixel(rgb444_to_565((part[1] & 0xF) << 8 | part[2]));
+			npart = 0;
+		}
+		break;
+	case CMD_COLMOD:
+		bpp = ((d & 0x7) == 0x3) ? 12 : 16;
+		break;
+	default:
+		break;
+	}
+}
+
+//----------------------------------------------------------------------------//
+// Transport interface
+//----------------------------------------------------------------------------//
+
+void lcd_io_init(void)
+{
+	memset(panel, 0, sizeof(panel));
+	cmd = 0;
+	nparam = npart = 0;
+	xs = ys = cx = cy = 0;
+	xe = LCD_W-1;
+	ye = LCD_H-1;
+	bpp = 16;
+}
+
+void lcd_io_command(uint8_t c)
+{
+	cmd = c;
+	nparam = 0;
+	npart = 0; // A partial pixel is dropped
+	if (c == CMD_RAMWR) {
+		cx = xs;
+		cy = ys;
+		stats.frames++;
+	}
+	stats.commands++;
+	stats.bytes++;
+}
+
+void lcd_io_data(const uint8_t *data, size_t len)
+{
+	stats.bytes += len;
+	if (cmd == CMD_RAMWR && npart == 0) {
+		// Fast paths for whole pixels
+		if (bpp == 16) {
+			for (; len >= 2; data += 2, len -= 2)
+				panel_pixel(data[0] << 8 | data[1]);
+		} else if (bpp == 12) {
+			for (; len >= 3; data += 3, len -= 3) {
+				panel_pixel(rgb444_to_565(data[0] << 4 | data[1] >> 4));
+				panel_pixel(rgb444_to_565((data[1] & 0xF) << 8 | data[2]));
+			}
+		}
+	}
+	while (len--) panel_data(*data++);
+}
+
+void lcd_io_delay(uint32_t ms)
+{
+	(void)ms;
+}
+
+void lcd_io_backlight(bool on)
+{
+	(void)on;
+}
+
+void lcd_io_clockFreq(int32_t freq)
+{
+	(void)freq;
+}
+
+void *lcd_io_alloc(size_t size)
+{
+	return malloc(size);
+}
+
+void lcd_io_free(void *ptr)
+{
+	free(ptr);
+}
+
+//----------------------------------------------------------------------------//
+// Virtual panel
+//----------------------------------------------------------------------------//
+
+void lcd_host_getStats(lcd_host_stats_t *s)
+{
+	*s = stats;
+}
+
+void lcd_host_resetStats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+const color_t *lcd_host_getPanel(void)
+{
+	return panel;
+}
+
+uint32_t lcd_host_checksum(void)
+{
+	uint32_t h = FNV_BASIS;
+	for (size_t i = 0; i < LCD_W*LCD_H; i++) {
+		h = (h ^ (panel[i] & 0xFF)) * FNV_PRIME;
+		h = (h ^ (panel[i] >> 8)) * FNV_PRIME;
+	}
+	return h;
+}
+
+int32_t lcd_host_writePPM(const char *path)
+{
+	FILE *f = fopen(path, "wb");
+	if (f == NULL) return -1;
+	fprintf(f, "P6\n%d %d\n255\n", LCD_W, LCD_H);
+	for (size_t i = 0; i < LCD_W*LCD_H; i++) {
+		uint8_t rgb[3] = {
+			(panel[i] >> 8) & 0xF8,
+			(panel[i] >> 3) & 0xFC,
+			(panel[i] << 3) & 0xF8,
+		};
+		fwrite(rgb, 1, sizeof(rgb), f);
+	}
+	return fclose(f) ? -1 : 0;
+}
@@ -0,0 +1,54 @@
+#ifndef LCD_HOST_H_
+#define LCD_HOST_H_
+/**
+ * @file
+ * @brief Virtual panel used when the LCD component is built on a host.
+ * @details lcd_host.c replaces the SPI transport with a panel model that
+ * decodes the same command and pixel bytes as the real controller into
+ * its own display memory. Bus traffic is counted so the cost of a drawing
+ * sequence can be compared between builds, and the panel contents can be
+ * checksummed or written to a PPM image file.
+ */
+
+#include <stdint.h>
+#include "lcd.h"
+
+/** @brief Bus traffic counters. */
+typedef struct {
+	uint64_t commands; ///< Command bytes sent.
+	uint64_t bytes;    ///< Total bytes sent (commands and data).
+	uint64_t pixels;   ///< Pixels written to display memory.
+	uint64_t frames;   ///< Memory write (2Ch) commands.
+} lcd_host_stats_t;
+
+/**
+ * @brief Get the bus traffic counters.
+ * @param stats Pointer to counters filled in by the call.
+ */
+void lcd_host_getStats(lcd_host_stats_t *stats);
+
+/**
+ * @brief Reset the bus traffic counters to zero.
+ */
+void lcd_host_resetStats(void);
+
+/**
+ * @brief Get the panel display memory.
+ * @returns A pointer to LCD_W * LCD_H color values in row-major order.
+ */
+const color_t *lcd_host_getPanel(void);
+
+/**
+ * @brief Compute a checksum of the panel display memory.
+ * @returns FNV-1a hash of the color values.
+ */
+uint32_t lcd_host_checksum(void);
+
+/**
+ * @brief Write the panel display memory to a binary PPM image file.
+ * @param path File name.
+ * @returns Zero if successful, or non-zero otherwise.
+ */
+int32_t lcd_host_writePPM(const char *path);
+
+#endif // LCD_HOST_H_
@@ -0,0 +1,76 @@
+#ifndef LCD_IO_H_
+#define LCD_IO_H_
+/**
+ * @file
+ * @brief Transport interface between the rasterizer (lcd.c) and the panel.
+ * @details The rasterizer encodes commands and pixels into bytes and hands
+ * them to a transport. lcd_spi.c sends the bytes to the panel over the SPI
+ * bus on the target. lcd_host.c feeds them to a virtual panel so the drawing
+ * code can be built and measured on a host (Linux) without a board.
+ * This header is private to the lcd component.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if defined(ESP_PLATFORM)
+#include "esp_log.h"
+#else
+#include <stdio.h>
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do {} while (0)
+#endif
+
+/**
+ * @brief Initialize the transport (bus, control pins) and reset the panel.
+ */
+void lcd_io_init(void);
+
+/**
+ * @brief Send a command byte to the panel.
+ * @param cmd Command value.
+ */
+void lcd_io_command(uint8_t cmd);
+
+/**
+ * @brief Send command parameters or pixel data to the panel.
+ * @param data Pointer to bytes. Must stay valid until the call returns.
+ * @param len  Number of bytes.
+ */
+void lcd_io_data(const uint8_t *data, size_t len);
+
+/**
+ * @brief Wait for the specified time.
+ * @param ms Delay in milliseconds.
+ */
+void lcd_io_delay(uint32_t ms);
+
+/**
+ * @brief Turn the backlight on or off.
+ * @param on True for on.
+ */
+void lcd_io_backlight(bool on);
+
+/**
+ * @brief Set the bus clock frequency used by the next lcd_io_init().
+ * @param freq Frequency in Hz.
+ */
+void lcd_io_clockFreq(int32_t freq);
+
+/**
+ * @brief Allocate memory for a frame buffer.
+ * @param size Size in bytes.
+ * @returns A pointer to the memory or NULL if the allocation failed.
+ */
+void *lcd_io_alloc(size_t size);
+
+/**
+ * @brief Free memory from lcd_io_alloc().
+ * @param ptr Pointer to the memory.
+ */
+void lcd_io_free(void *ptr);
+
+#endif // LCD_IO_H_
@@ -0,0 +1,185 @@
+// SPI transport for the LCD rasterizer (lcd.c) on ESP-IDF targets.
+// Modified from: https://github.com/nopnop2002/esp-idf-st7789
+
+#include <string.h> // memset
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#include "hw.h"
+#include "lcd_io.h"
+
+#define LCD_MOSI HW_LCD_MOSI
+#define LCD_SCLK HW_LCD_SCLK
+#define LCD_CS   HW_LCD_CS
+#define LCD_DC   HW_LCD_DC
+#define LCD_RST  HW_LCD_RST
+#define LCD_BL   HW_LCD_BL
+
+#define LCD_SPI_HOST HW_LCD_SPI_HOST
+#define LCD_SPI_FREQ HW_LCD_SPI_FREQ
+
+typedef enum {
+	SPI_Command_Mode = 0,
+	SPI_Data_Mode = 1
+} spi_mode_t;
+
+static const char *TAG = "lcd";
+
+static int32_t clock_freq_hz = LCD_SPI_FREQ;
+static spi_device_handle_t SPIHandle;
+
+#define delayMS(ms) \
+	vTaskDelay(((ms)+(portTICK_PERIOD_MS-1))/portTICK_PERIOD_MS)
+
+static void spi_master_init(int16_t GPIO_MOSI, int16_t GPIO_SCLK, int16_t GPIO_CS, int16_t GPIO_DC, int16_t GPIO_RST, int16_t GPIO_BL)
+{
+	esp_err_t ret;
+
+	ESP_LOGI(TAG, "GPIO_BL=%hd", GPIO_BL);
+	if ( GPIO_BL >= 0 ) {
+		gpio_reset_pin(GPIO_BL);
+		gpio_set_direction( GPIO_BL, GPIO_MODE_OUTPUT );
+		gpio_set_level( GPIO_BL, 0 );
+	}
+
+	ESP_LOGI(TAG, "GPIO_CS=%hd",GPIO_CS);
+	if ( GPIO_CS >= 0 ) {
+		gpio_reset_pin( GPIO_CS );
+		gpio_set_direction( GPIO_CS, GPIO_MODE_OUTPUT );
+		gpio_set_level( GPIO_CS, 0 );
+	}
+
+	ESP_LOGI(TAG, "GPIO_DC=%hd",GPIO_DC);
+	gpio_reset_pin( GPIO_DC );
+	gpio_set_direction( GPIO_DC, GPIO_MODE_OUTPUT );
+	gpio_set_level( GPIO_DC, 0 );
+
+	ESP_LOGI(TAG, "GPIO_RST=%hd", GPIO_RST);
+	if ( GPIO_RST >= 0 ) {
+		gpio_reset_pin( GPIO_RST );
+		gpio_set_direction( GPIO_RST, GPIO_MODE_OUTPUT );
+		gpio_set_level( GPIO_RST, 1 );
+	}
+
+	ESP_LOGI(TAG, "GPIO_MOSI=%hd", GPIO_MOSI);
+	ESP_LOGI(TAG, "GPIO_SCLK=%hd", GPIO_SCLK);
+	spi_bus_config_t buscfg = {
+		.mosi_io_num = GPIO_MOSI,
+		.miso_io_num = -1,
+		.sclk_io_num = GPIO_SCLK,
+		.quadwp_io_num = -1,
+		.quadhd_io_num = -1,
+		.max_transfer_sz = 0,
+		.flags = 0
+	};
+
+	ret = spi_bus_initialize( LCD_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO );
+	ESP_LOGD(TAG, "spi_bus_initialize=%d",(int)ret);
+	assert(ret==ESP_OK);
+
+	spi_device_interface_config_t devcfg;
+	memset(&devcfg, 0, sizeof(devcfg));
+	devcfg.clock_speed_hz = clock_freq_hz;
+	devcfg.queue_size = 7;
+	devcfg.mode = 3;
+	devcfg.flags = SPI_DEVICE_NO_DUMMY;
+
+	if ( GPIO_CS >= 0 ) {
+		devcfg.spics_io_num = GPIO_CS;
+	} else {
+		devcfg.spics_io_num = -1;
+	}
+
+	ret = spi_bus_add_device( LCD_SPI_HOST, &devcfg, &SPIHandle);
+	ESP_LOGD(TAG, "spi_bus_add_device=%d",(int)ret);
+	assert(ret==ESP_OK);
+}
+
+static bool spi_master_write_bytes(spi_device_handle_t SPIHandle, const uint8_t* Data, size_t DataLength)
+{
+	spi_transaction_t SPITransaction;
+	esp_err_t ret;
+
+	if ( DataLength > 0 ) {
+		memset( &SPITransaction, 0, sizeof( spi_transaction_t ) );
+		SPITransaction.length = DataLength * 8;
+		SPITransaction.tx_buffer = Data;
+#if 0
+		ret = spi_device_transmit( SPIHandle, &SPITransaction );
+#else
+		ret = spi_device_polling_transmit( SPIHandle, &SPITransaction );
+#endif
+		assert(ret==ESP_OK);
+	}
+
+	return true;
+}
+
+//----------------------------------------------------------------------------//
+// Transport interface
+//----------------------------------------------------------------------------//
+
+void lcd_io_init(void)
+{
+	spi_master_init(
+		LCD_MOSI,
+		LCD_SCLK,
+		LCD_CS,
+		LCD_DC,
+		LCD_RST,
+		LCD_BL);
+
+	if (LCD_RST >= 0) {
+		gpio_set_level(LCD_RST, 0);
+		delayMS(20);
+		gpio_set_level(LCD_RST, 1);
+		delayMS(120);
+	}
+}
+
+void lcd_io_command(uint8_t cmd)
+{
+	static uint8_t Byte = 0;
+	Byte = cmd;
+	gpio_set_level( LCD_DC, SPI_Command_Mode );
+	spi_master_write_bytes( SPIHandle, &Byte, 1 );
+}
+
+void lcd_io_data(const uint8_t *data, size_t len)
+{
+	gpio_set_level( LCD_DC, SPI_Data_Mode );
+	spi_master_write_bytes( SPIHandle, data, len );
+}
+
+void lcd_io_delay(uint32_t ms)
+{
+	delayMS(ms);
+}
+
+void lcd_io_backlight(bool on)
+{
+	if (LCD_BL >= 0) {
+		gpio_set_level(LCD_BL, on);
+	}
+}
+
+void lcd_io_clockFreq(int32_t freq)
+{
+	clock_freq_hz = freq;
+}
+
+void *lcd_io_alloc(size_t size)
+{
+	return heap_caps_malloc(size, MALLOC_CAP_DMA);
+}
+
+void lcd_io_free(void *ptr)
+{
+	heap_caps_free(ptr);
+}
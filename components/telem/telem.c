@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <string.h> // memset
+
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+#include "lcd.h"
+#include "telem.h"
+
+#define BUCKETS 128 // Four per power of two for 32-bit values
+#define SUB_BITS 2  // log2 of buckets per power of two
+#define RING_MASK (TELEM_RING_LEN-1)
+#define LINE_LEN 40
+
+typedef struct {
+	uint32_t hist[BUCKETS];
+	uint32_t count;
+	uint32_t max;
+	uint64_t sum;
+} stage_t;
+
+static stage_t stages[TELEM_MAX_STAGES];
+static const char *const *snames;
+static uint32_t nstages;
+
+static telem_sample_t ring[TELEM_RING_LEN];
+static uint32_t ring_head; // Total samples written
+static uint32_t missed;
+
+static portMUX_TYPE spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+
+// Bucket index of a value. Values below 4 have their own bucket. Above
+// that, each power of two is split into four buckets by the two bits
+// below the leading one.
+static inline uint32_t bucket(uint32_t v)
+{
+	if (v < (1U << SUB_BITS)) return v;
+	uint32_t o = 31 - __builtin_clz(v);
+	uint32_t sub = (v >> (o - SUB_BITS)) & ((1U << SUB_BITS) - 1);
+	return ((o - SUB_BITS + 1) << SUB_BITS) + sub;
+}
+
+// Largest value that falls in a bucket.
+static uint32_t bucket_hi(uint32_t b)
+{
+	if (b < (1U << SUB_BITS)) return b;
+	uint32_t o = (b >> SUB_BITS) + SUB_BITS - 1;
+	uint32_t sub = b & ((1U << SUB_BITS) - 1);
+	uint64_t lo = (uint64_t)((1U << SUB_BITS) + sub) << (o - SUB_BITS);
+	return lo + (1ULL << (o - SUB_BITS)) - 1;
+}
+
+// Value at percentile pct (0-100) of a histogram with count samples.
+static uint32_t percentile(const uint32_t *hist, uint32_t count, uint32_t pct)
+{
+	if (count == 0) return 0;
+	uint32_t rank = ((uint64_t)count * pct + 99) / 100; // ceil
+	if (rank == 0) rank = 1;
+	uint32_t sum = 0;
+	for (uint32_t b = 0; b < BUCKETS; b++) {
+		sum += hist[b];
+		if (sum >= rank) return bucket_hi(b);
+	}
+	return bucket_hi(BUCKETS-1);
+}
+
+// Initialize telemetry and clear all samples.
+// names: array of stage names, used by telem_print() and telem_draw().
+// n: number of stages, up to TELEM_MAX_STAGES.
+// Return zero if successful, or non-zero otherwise.
+int32_t telem_init(const char *const *names, uint32_t n)
+{
+	if (names == NULL || n == 0 || n > TELEM_MAX_STAGES) return -1;
+	snames = names;
+	nstages = n;
+	telem_reset();
+	return 0;
+}
+
+// Clear all samples, histograms and counts.
+void telem_reset(void)
+{
+	portENTER_CRITICAL(&spinlock);
+	memset(stages, 0, sizeof(stages));
+	ring_head = 0;
+	missed = 0;
+	portEXIT_CRITICAL(&spinlock);
+}
+
+// Get a timestamp to mark the start of a stage.
+// Return the current time in us.
+int64_t telem_now(void)
+{
+	return esp_timer_get_time();
+}
+
+// Record a stage that started at a time from telem_now().
+// stage: stage number.
+// start: start time from telem_now().
+// Return the current time, so it can start the next stage.
+int64_t telem_record(uint32_t stage, int64_t start)
+{
+	int64_t now = esp_timer_get_time();
+	if (stage >= nstages) return now;
+	uint32_t dur = now - start;
+	stage_t *s = &stages[stage];
+
+	portENTER_CRITICAL(&spinlock);
+	s->hist[bucket(dur)]++;
+	s->count++;
+	s->sum += dur;
+	if (dur > s->max) s->max = dur;
+	telem_sample_t *r = &ring[ring_head++ & RING_MASK];
+	r->start = start;
+	r->dur = (dur > UINT16_MAX) ? UINT16_MAX : dur;
+	r->stage = stage;
+	portEXIT_CRITICAL(&spinlock);
+	return now;
+}
+
+// Add to the count of missed timer ticks (periods with no frame).
+// n: number of ticks missed.
+void telem_missed(uint32_t n)
+{
+	portENTER_CRITICAL(&spinlock);
+	missed += n;
+	portEXIT_CRITICAL(&spinlock);
+}
+
+// Get the count of missed timer ticks.
+uint32_t telem_get_missed(void)
+{
+	return missed;
+}
+
+// Get the statistics for a stage.
+// stage: stage number.
+// *stats: pointer to statistics filled in by the call.
+void telem_get(uint32_t stage, telem_stats_t *stats)
+{
+	static uint32_t hist[BUCKETS]; // Not on the caller's stack
+	uint32_t count, max;
+	uint64_t sum;
+
+	memset(stats, 0, sizeof(*stats));
+	if (stage >= nstages) return;
+	portENTER_CRITICAL(&spinlock);
+	memcpy(hist, stages[stage].hist, sizeof(hist));
+	count = stages[stage].count;
+	max = stages[stage].max;
+	sum = stages[stage].sum;
+	portEXIT_CRITICAL(&spinlock);
+
+	stats->count = count;
+	if (count == 0) return;
+	stats->mean = sum / count;
+	stats->p50 = percentile(hist, count, 50);
+	stats->p95 = percentile(hist, count, 95);
+	stats->p99 = percentile(hist, count, 99);
+	stats->max = max;
+	// The bucket bound can exceed the exact maximum.
+	if (stats->p50 > max) stats->p50 = max;
+	if (stats->p95 > max) stats->p95 = max;
+	if (stats->p99 > max) stats->p99 = max;
+}
+
+// Copy the most recent samples from the ring buffer, oldest first.
+// *buf: pointer to an array for the samples.
+// max: size of the array.
+// Return the number of samples copied.
+uint32_t telem_history(telem_sample_t *buf, uint32_t max)
+{
+	portENTER_CRITICAL(&spinlock);
+	uint32_t n = (ring_head < TELEM_RING_LEN) ? ring_head : TELEM_RING_LEN;
+	if (n > max) n = max;
+	for (uint32_t i = 0, j = ring_head - n; i < n; i++, j++)
+		buf[i] = ring[j & RING_MASK];
+	portEXIT_CRITICAL(&spinlock);
+	return n;
+}
+
+// Print the statistics for all stages.
+void telem_print(void)
+{
+	telem_stats_t st;
+
+	printf("%-10s %8s %8s %8s %8s %8s %8s\n",
+		"stage", "count", "mean", "p50", "p95", "p99", "max");
+	for (uint32_t i = 0; i < nstages; i++) {
+		telem_get(i, &st);
+		printf("%-10s %8lu %8lu %8lu %8lu %8lu %8lu\n", snames[i],
+			(unsigned long)st.count, (unsigned long)st.mean,
+			(unsigned long)st.p50, (unsigned long)st.p95,
+			(unsigned long)st.p99, (unsigned long)st.max);
+	}
+	printf("missed ticks: %lu\n", (unsigned long)missed);
+}
+
+// Draw the statistics as a small text overlay (one line per stage).
+// x, y: top left corner.
+// color: text color.
+void telem_draw(coord_t x, coord_t y, color_t color)
+{
+	telem_stats_t st;
+	char line[LINE_LEN];
+
+	lcd_setFontSize(1);
+	lcd_setFontDirection(DIRECTION0);
+	for (uint32_t i = 0; i < nstages; i++, y += LCD_CHAR_H) {
+		telem_get(i, &st);
+		snprintf(line, sizeof(line), "%-7.7s%6lu%6lu%6lu", snames[i],
+			(unsigned long)st.p50, (unsigned long)st.p99,
+			(unsigned long)st.max);
+		lcd_drawString(x, y, line, color);
+	}
+	snprintf(line, sizeof(line), "missed %lu", (unsigned long)missed);
+	lcd_drawString(x, y, line, color);
+}
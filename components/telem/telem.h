@@ -0,0 +1,84 @@
+#ifndef TELEM_H_
+#define TELEM_H_
+
+#include <stdint.h>
+
+#include "lcd.h" // coord_t, color_t
+
+// This component collects timing telemetry for the stages of a frame.
+// The application numbers its stages from zero and brackets each one with
+// telem_now() and telem_record(). Each record goes into a fixed ring
+// buffer of recent samples and into a log-scale histogram per stage, from
+// which percentiles are read at runtime. A record costs one timer read and
+// a short critical section, and may be made from tasks on either core.
+//
+// Histogram buckets are spaced four per power of two, so a reported
+// percentile is the upper bound of its bucket, within 25% of the true
+// value. Samples are in microseconds.
+
+#define TELEM_MAX_STAGES 8   // Maximum number of stages
+#define TELEM_RING_LEN   256 // Number of recent samples kept (power of two)
+
+// A recent sample from the ring buffer.
+typedef struct {
+	uint32_t start; // Start time in us (low 32 bits of esp_timer_get_time)
+	uint16_t dur;   // Duration in us, saturated at 65535
+	uint16_t stage; // Stage number
+} telem_sample_t;
+
+// Statistics for a stage.
+typedef struct {
+	uint32_t count; // Number of samples
+	uint32_t mean;  // Mean in us
+	uint32_t p50;   // Percentiles in us
+	uint32_t p95;
+	uint32_t p99;
+	uint32_t max;   // Maximum in us (exact)
+} telem_stats_t;
+
+// Initialize telemetry and clear all samples.
+// names: array of stage names, used by telem_print() and telem_draw().
+// n: number of stages, up to TELEM_MAX_STAGES.
+// Return zero if successful, or non-zero otherwise.
+int32_t telem_init(const char *const *names, uint32_t n);
+
+// Clear all samples, histograms and counts.
+void telem_reset(void);
+
+// Get a timestamp to mark the start of a stage.
+// Return the current time in us.
+int64_t telem_now(void);
+
+// Record a stage that started at a time from telem_now().
+// stage: stage number.
+// start: start time from telem_now().
+// Return the current time, so it can start the next stage.
+int64_t telem_record(uint32_t stage, int64_t start);
+
+// Add to the count of missed timer ticks (periods with no frame).
+// n: number of ticks missed.
+void telem_missed(uint32_t n);
+
+// Get the count of missed timer ticks.
+uint32_t telem_get_missed(void);
+
+// Get the statistics for a stage.
+// stage: stage number.
+// *stats: pointer to statistics filled in by the call.
+void telem_get(uint32_t stage, telem_stats_t *stats);
+
+// Copy the most recent samples from the ring buffer, oldest first.
+// *buf: pointer to an array for the samples.
+// max: size of the array.
+// Return the number of samples copied.
+uint32_t telem_history(telem_sample_t *buf, uint32_t max);
+
+// Print the statistics for all stages.
+void telem_print(void);
+
+// Draw the statistics as a small text overlay (one line per stage).
+// x, y: top left corner.
+// color: text color.
+void telem_draw(coord_t x, coord_t y, color_t color);
+
+#endif // TELEM_H_
@@ -1,8 +1,44 @@
 #ifndef CONFIG_H_
 #define CONFIG_H_
 
+// Render (frame) period in seconds
 #define CONFIG_GAME_TIMER_PERIOD 40.0E-3f
 
+// Fixed physics step in seconds (200 Hz). The main loop runs as many steps
+// as real elapsed time requires before each frame, up to the maximum,
+// after which the simulation drops time instead of falling further behind.
+#define CONFIG_PHYSICS_STEP 5.0E-3f
+#define CONFIG_PHYSICS_MAX_STEPS 16
+
+// Capacity of the extra ball set (multi-ball)
+#ifndef CONFIG_MAX_BALLS
+#define CONFIG_MAX_BALLS 32
+#endif
+
+// Capacity of the particle pool (brick-break effects). The governor
+// scales the number in use down from this cap (see particle.h).
+#ifndef CONFIG_MAX_PARTICLES
+#define CONFIG_MAX_PARTICLES 256
+#endif
+
+// Extra balls kept in play to stress physics and rendering (0 for off)
+#define CONFIG_STRESS_BALLS 0
+
+// Size in bytes of the buffer recording the game input (see input.h).
+// The log is printed in hex when the game exits.
+#define CONFIG_INPUT_LOG_SIZE 32768
+
+// Late latch: the render task reads the joystick just before presenting
+// a frame and moves the drawn platform to it, so the platform on screen
+// lags the stick by less than a frame. The simulation is not changed.
+#define CONFIG_LATE_LATCH 1
+
+// Start with the autoplay bot playing (soak tests), SELECT toggles it
+#define CONFIG_AUTOPLAY 0
+
+// Physics uses Q16.16 fixed point (see phys.h). Uncomment to use float.
+// #define CONFIG_PHYSICS_FLOAT
+
 #define CONFIG_MAX_PLAYER_MISSILES 4
 #define CONFIG_MAX_ENEMY_MISSILES  7
 #define CONFIG_MAX_PLANE_MISSILES  1
@@ -0,0 +1,50 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event.h"
+
+#define MASK (EVENT_RING_SIZE - 1)
+
+_Static_assert((EVENT_RING_SIZE & MASK) == 0, "EVENT_RING_SIZE must be a power of two");
+
+/************************ Initialization *************************/
+void event_init(event_ring_t *ring) {
+    if (!ring) return;
+
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    ring->dropped = 0;
+}
+
+/************************ Producer *************************/
+bool event_push(event_ring_t *ring, const event_t *e) {
+    // Only the producer writes head
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= EVENT_RING_SIZE) {
+        ring->dropped++;
+        return false;
+    }
+    ring->buf[head & MASK] = *e;
+    // Publish the slot before the index that covers it
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+/************************ Consumer *************************/
+bool event_pop(event_ring_t *ring, event_t *e) {
+    // Only the consumer writes tail
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) return false;
+    *e = ring->buf[tail & MASK];
+    // Free the slot after it is read
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool event_empty(event_ring_t *ring) {
+    return atomic_load_explicit(&ring->tail, memory_order_relaxed) ==
+           atomic_load_explicit(&ring->head, memory_order_acquire);
+}
@@ -0,0 +1,60 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Game events for consumers outside the physics (sound, lights, score,
+// network). game_tick() pushes each event into the rings of the
+// consumers, and each consumer drains its own ring, possibly on another
+// task or core.
+//
+// A ring has a single producer and a single consumer, so it needs no lock:
+// the producer only writes head and the consumer only writes tail, and
+// each publishes its index after the slot it covers is written or read.
+// A push to a full ring drops the event instead of waiting, so the
+// producer never blocks on a slow consumer.
+
+#define EVENT_RING_SIZE 64 // Events per ring, a power of two
+
+// Event types
+typedef enum {
+    EVENT_HIT,         // A ball hit something, a = COLLIDE_* bits
+    EVENT_BRICK,       // Brick destroyed, a = row, b = column
+    EVENT_BALL_LOST,   // The ball fell off the bottom
+    EVENT_LEVEL_CLEAR, // Every brick cleared, a = level cleared
+} event_type_t;
+
+typedef struct {
+    uint8_t type;      // event_type_t
+    uint8_t a, b;      // Arguments, by type
+    uint8_t pad;
+    int16_t x, y;      // Position on the screen, if any
+} event_t;
+
+typedef struct {
+    event_t buf[EVENT_RING_SIZE];
+    _Atomic uint32_t head; // Next slot written (producer)
+    _Atomic uint32_t tail; // Next slot read (consumer)
+    uint32_t dropped;      // Events dropped when full (producer)
+} event_ring_t;
+
+/************************ Function Prototypes *************************/
+
+// Initialize an empty ring (before the producer and consumer use it)
+void event_init(event_ring_t *ring);
+
+// Push an event (producer only).
+// Return false if the ring is full and the event was dropped.
+bool event_push(event_ring_t *ring, const event_t *e);
+
+// Pop the oldest event (consumer only).
+// *e: filled in with the event.
+// Return false if the ring is empty.
+bool event_pop(event_ring_t *ring, event_t *e);
+
+// Return true if the ring has no events to pop
+bool event_empty(event_ring_t *ring);
+
+#endif // EVENT_H
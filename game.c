@@ -1,100 +1,329 @@
 #include <stdio.h>
 #include <stdlib.h> // rand
+#include <string.h> // memcpy
 #include <inttypes.h> // For PRIu32
 
 #include "hw.h"
 #include "lcd.h"
 #include "cursor.h"
 #include "sound.h"
-#include "pin.h"
+#include "event.h"
+#include "input.h"
+#include "autoplay.h"
+#include "level.h"
 #include "ball.h"
+#include "balls.h"
+#include "particle.h"
 #include "platform.h"
 #include "brick.h"
+#include "collide.h"
 #include "game.h"
+#include "render.h"
 #include "config.h"
 // sound support
-#include "missileLaunch.h"
-#include "bigx.h"
+#include "userSound.h" // bounce sound
+#include "bigx.h" // lost sound
 
 #define THREE_HUN 300
 #define SHOTS_X 10
 #define STATS_Y 10
 
+#define STRESS_SEED 1
+#define MAX_RINGS 4 // Event consumers
+
 // Global game objects
 ball_t game_ball;
+ball_set_t game_balls; // Extra balls
+particle_set_t game_particles; // Brick-break effects
 platform_t game_platform;
 brick_grid_t game_bricks;
 
 static int total_bricks = 0;
 static int broken_bricks = 0;
 
+static level_pack_t levels; // Levels played, the built-in pack if none
+static uint32_t level;       // Current level
+
+static event_ring_t *rings[MAX_RINGS]; // Event consumers
+static uint32_t num_rings;
+
+// Snapshots to start again without setting up the objects: the start of
+// a game, and the start of the current level after a lost ball
+static game_state_t start, retry;
+static bool start_saved, retry_saved;
+
+static uint32_t stress_balls; // Extra balls kept in play
+static uint32_t stress_seed;
+
+// Pseudo-random number for stress balls, the same sequence every game
+static uint32_t stress_rand(uint32_t n)
+{
+    stress_seed = stress_seed * 1103515245 + 12345;
+    return (stress_seed >> 16) % n;
+}
+
+// Add extra balls until there are stress_balls in play
+static void stress_fill(void)
+{
+    while (game_balls.count < stress_balls) {
+        phys_t x = phys_from_int(20 + stress_rand(LCD_W - 40));
+        phys_t y = phys_from_int(LCD_H/2 + stress_rand(LCD_H/4));
+        phys_t dx = phys_from_int(50 + stress_rand(100));
+        phys_t dy = phys_from_int(-50 - (int32_t)stress_rand(100));
+        if (stress_rand(2)) dx = -dx;
+        if (balls_add(&game_balls, x, y, dx, dy) < 0) break;
+    }
+}
+
+// Push an event to every consumer
+static void emit(event_type_t type, uint8_t a, uint8_t b, phys_t x, phys_t y)
+{
+    event_t e = {type, a, b, 0, phys_floor(x), phys_floor(y)};
+    for (uint32_t i = 0; i < num_rings; i++)
+        event_push(rings[i], &e);
+}
+
+// Report and burst the bricks alive before a step and gone after it
+static void broken(const brick_mask_t *before)
+{
+    for (int r = 0; r < game_bricks.rows; r++) {
+        brick_mask_t gone = before[r] & ~game_bricks.alive[r];
+        for (int c = 0; gone; c++, gone >>= 1) {
+            if (!(gone & 1)) continue;
+            phys_t x, y, w, h;
+            bricks_get_box(&game_bricks, r, c, &x, &y, &w, &h);
+            emit(EVENT_BRICK, r, c, x + w/2, y + h/2);
+            particles_burst(&game_particles, x, y, w, h,
+                            bricks_get_color(&game_bricks, r, c), PARTICLE_BURST);
+        }
+    }
+}
+
+// Set up the bricks of the current level, the default layout if the
+// level can't be loaded
+static void load_level(void)
+{
+    if (!levels.count)
+        level_open(&levels, level_builtin, level_builtin_size);
+    if (level_load(&levels, level, &game_bricks))
+        bricks_init(&game_bricks);
+    total_bricks = bricks_get_alive_count(&game_bricks);
+    broken_bricks = 0;
+}
+
 // Initialize game
 void game_init(void)
 {
     // Initialize game objects
     ball_init(&game_ball);
+    balls_init(&game_balls, game_ball.radius, game_ball.color);
     platform_init(&game_platform, THREE_HUN); // 300 = move speed
-    bricks_init(&game_bricks);
-    
-    // Initialize stats
-    total_bricks = game_bricks.rows * game_bricks.cols;
-    broken_bricks = 0;
-    
-    // Initialize joystick
-    // joy_init();
+    load_level();
+    stress_seed = STRESS_SEED;
+    stress_fill();
+}
+
+int32_t game_levels(const void *data, uint32_t size)
+{
+    level = 0;
+    start_saved = retry_saved = false;
+    if (!data) return level_open(&levels, level_builtin, level_builtin_size);
+    return level_open(&levels, data, size);
+}
+
+void game_restart(void)
+{
+    if (start_saved) {
+        game_load(&start);
+    } else {
+        level = 0;
+        ball_first_round();
+        particles_init(&game_particles);
+        game_init();
+        game_save(&start);
+        start_saved = true;
+    }
+    stress_fill();
+}
+
+// Start the current level again after a lost ball. The level is set up
+// once and saved, and later tries restore it.
+static void retry_level(void)
+{
+    if (retry_saved && retry.level == level && retry.speed == ball_get_speed()) {
+        game_load(&retry);
+        stress_fill();
+        return;
+    }
+    particles_clear(&game_particles);
+    game_init();
+    game_save(&retry);
+    retry_saved = true;
+}
+
+void game_save(game_state_t *state)
+{
+    state->ball = game_ball;
+    state->balls = game_balls;
+    state->platform = game_platform;
+    state->bricks = game_bricks;
+    state->particles = game_particles;
+    state->speed = ball_get_speed();
+    state->level = level;
+    state->total_bricks = total_bricks;
+    state->broken_bricks = broken_bricks;
+    state->stress_seed = stress_seed;
+}
+
+void game_load(const game_state_t *state)
+{
+    uint16_t cap = game_particles.cap;
+    game_ball = state->ball;
+    game_balls = state->balls;
+    game_platform = state->platform;
+    bricks_copy(&game_bricks, &state->bricks);
+    game_particles = state->particles;
+    particles_set_cap(&game_particles, cap);
+    ball_set_speed(state->speed);
+    level = state->level;
+    total_bricks = state->total_bricks;
+    broken_bricks = state->broken_bricks;
+    stress_seed = state->stress_seed;
 }
 
 // Main game tick function
-void game_tick(void)
+void game_tick(phys_t dt)
 {
-    // Get platform position for collision checking
-    float plat_x, plat_y, plat_w, plat_h;
+    // Move the balls, bouncing off everything they hit on the way
+    phys_t plat_x, plat_y, plat_w, plat_h;
     platform_get_pos(&game_platform, &plat_x, &plat_y, &plat_w, &plat_h);
-    
-    // Check platform collision
-    ball_check_platform_collision(&game_ball, plat_x, plat_y, plat_w, plat_h);
-    
-    // Check brick collisions
-    coord_t ball_x, ball_y;
-    ball_get_pos(&game_ball, &ball_x, &ball_y);
-    
-    if (bricks_check_collision(&game_bricks, 
-                               (float)ball_x, (float)ball_y, 
-                               (float)game_ball.radius)) {
-        broken_bricks++;
-        // Optional: play sound here
-        // sound_start(missileLaunch, MISSILELAUNCH_LENGTH);
-    }
+    collide_result_t res = {0, 0, 0, 0}, more = {0, 0, 0, 0};
+    brick_mask_t alive[MAX_BRICK_ROWS];
+    memcpy(alive, game_bricks.alive, sizeof(alive));
+    if (ball_is_moving(&game_ball))
+        res = collide_move_ball(&game_ball, dt, &game_bricks,
+                                plat_x, plat_y, plat_w, plat_h);
+    if (game_balls.count)
+        more = collide_move_balls(&game_balls, dt, &game_bricks,
+                                  plat_x, plat_y, plat_w, plat_h);
+    broken_bricks += res.bricks + more.bricks;
+    if (res.bricks || more.bricks)
+        broken(alive);
+    particles_tick(&game_particles, dt);
+    // Hits of the main ball and of the extra balls, each where it hit
+    if (res.hits)
+        emit(EVENT_HIT, res.hits, 0, res.x, res.y);
+    if (more.hits)
+        emit(EVENT_HIT, more.hits, 0, more.x, more.y);
+    balls_tick(&game_balls);
+    stress_fill();
     
     // Check if all bricks cleared (level complete)
     if (bricks_all_cleared(&game_bricks)) {
+        emit(EVENT_LEVEL_CLEAR, level, 0, game_ball.x, game_ball.y);
         ball_next_round(&game_ball);
-        bricks_init(&game_bricks);
-        total_bricks = game_bricks.rows * game_bricks.cols;
-        broken_bricks = 0;
+        if (++level >= levels.count) level = 0;
+        load_level();
     }
     
     // Check if ball was lost
     if (ball_is_lost(&game_ball)) {
         // Reset ball for next attempt
-        sound_start(bigx,BIGX_SAMPLES, false);
-        game_init();
+        emit(EVENT_BALL_LOST, 0, 0, game_ball.x, game_ball.y);
+        retry_level();
     }
     
     // Launch ball with button press (BTN_A or BTN_START)
-    if (!pin_get_level(HW_BTN_A) || !pin_get_level(HW_BTN_START)) {
+    if (input_down(INPUT_A | INPUT_START)) {
         ball_launch(&game_ball);
     }
     
-    // Update and draw everything (state machines handle their own drawing)
-    platform_tick(&game_platform);
-    bricks_tick(&game_bricks);
+    // Update everything
+    platform_tick(&game_platform, dt);
     ball_tick(&game_ball);
-    
-    // Draw stats
+}
+
+int32_t game_events(event_ring_t *ring)
+{
+    if (!ring || num_rings >= MAX_RINGS) return -1;
+    rings[num_rings++] = ring;
+    return 0;
+}
+
+// Sound consumer: a sound for each kind of event
+void game_sound(const event_t *e)
+{
+    switch (e->type) {
+        case EVENT_HIT:
+            sound_start(userSound, USERSOUND_SAMPLES, false);
+            break;
+        case EVENT_BALL_LOST:
+            sound_start(bigx, BIGX_SAMPLES, false);
+            break;
+        default: break;
+    }
+}
+
+// Autoplay bot for the input module
+void game_autoplay(input_t *in)
+{
+    autoplay_steer(in, &game_ball, &game_platform, &game_bricks);
+}
+
+// Copy the game objects for the renderer
+void game_snapshot(game_frame_t *frame)
+{
+    frame->ball = game_ball;
+    frame->balls = game_balls;
+    frame->particles = game_particles;
+    frame->platform = game_platform;
+    frame->bricks = game_bricks;
+    bricks_clean(&game_bricks); // The frame draws the changes
+}
+
+void game_particle_cap(uint32_t cap)
+{
+    particles_set_cap(&game_particles, cap);
+}
+
+void game_skip(game_frame_t *frame, const game_frame_t *skipped)
+{
+    bricks_merge_dirty(&frame->bricks, &skipped->bricks);
+}
+
+void game_stress(uint32_t balls)
+{
+    stress_balls = balls;
+    stress_fill();
+}
+
+// Draw everything from a simulated state, the platform last
+void game_draw(game_frame_t *frame)
+{
+    game_draw_scene(frame);
+    game_draw_stats(frame);
+    game_draw_platform(frame);
+}
+
+void game_draw_platform(game_frame_t *frame)
+{
+    platform_draw(&frame->platform);
+}
+
+void game_draw_scene(game_frame_t *frame)
+{
+    bricks_draw(&frame->bricks);
+    ball_draw(&frame->ball);
+    balls_draw(&frame->balls);
+    particles_draw(&frame->particles);
+}
+
+void game_draw_stats(game_frame_t *frame)
+{
     char text_buffer[32];
-    uint32_t remaining = bricks_get_alive_count(&game_bricks);
-    snprintf(text_buffer, sizeof(text_buffer), "Bricks: %lu", 
+    uint32_t remaining = bricks_get_alive_count(&frame->bricks);
+    int len = snprintf(text_buffer, sizeof(text_buffer), "Bricks: %lu", 
              (unsigned long)remaining);
     lcd_drawString(SHOTS_X, STATS_Y, text_buffer, CONFIG_COLOR_STATUS);
+    render_add(SHOTS_X, STATS_Y, len*LCD_CHAR_W, LCD_CHAR_H);
 }
@@ -1,14 +1,120 @@
 #ifndef GAME_H_
 #define GAME_H_
 
+#include "ball.h"
+#include "balls.h"
+#include "particle.h"
+#include "platform.h"
+#include "brick.h"
+#include "input.h"
+#include "event.h"
+
+// State of the game objects needed to draw a frame. The simulation
+// fills one in after its physics steps and the renderer draws from it,
+// so drawing never reads objects that are being updated.
+typedef struct {
+    ball_t ball;
+    ball_set_t balls;
+    particle_set_t particles;
+    platform_t platform;
+    brick_grid_t bricks;
+} game_frame_t;
+
+// Whole state of a game: everything game_tick() reads and changes. It is
+// plain data, so a snapshot is a copy of the struct that can be kept,
+// stored or sent, and restoring it puts the game back exactly (for
+// instant retries, rewind and rollback).
+typedef struct {
+    ball_t ball;
+    ball_set_t balls;
+    platform_t platform;
+    brick_grid_t bricks;
+    particle_set_t particles;
+    phys_t speed;          // Ball speed multiplier, see ball_get_speed()
+    uint32_t level;        // Current level
+    int32_t total_bricks;  // Bricks at the start of the level
+    int32_t broken_bricks; // Bricks broken in the level (score)
+    uint32_t stress_seed;  // Random state for stress balls
+} game_state_t;
+
 // Initialize the game control logic.
 // This function initializes all missiles, planes, stats, etc.
 void game_init(void);
 
-// Update the game control logic.
-// This function calls the missile & plane tick functions, reinitializes
-// idle enemy missiles, handles button presses, fires player missiles,
-// detects collisions, and updates statistics.
-void game_tick(void);
+// Start a new game from the first round. Unlike game_init(), which
+// resets the objects after a lost ball, nothing carries over from an
+// earlier game, so the same input replays the same game. The first call
+// sets up the game and saves it; later calls restore the saved state.
+void game_restart(void);
+
+// Save the state of the game.
+// state: pointer to the state filled in by the call.
+void game_save(game_state_t *state);
+
+// Restore a state saved by game_save(). The particle cap is kept (see
+// game_particle_cap()).
+// state: pointer to the saved state.
+void game_load(const game_state_t *state);
+
+// Play the levels of a level pack (see level.h), from the first level of
+// the next game. Cleared levels advance to the next, and the last wraps
+// around to the first.
+// data, size: pack data and size in bytes, or NULL for the built-in pack.
+// Return zero if successful, or non-zero if the data is not a pack.
+int32_t game_levels(const void *data, uint32_t size);
+
+// Update the game control logic by one physics step of dt seconds.
+// This function calls the ball, platform & brick tick functions,
+// handles button presses, detects collisions, and updates statistics.
+// It does not draw.
+void game_tick(phys_t dt);
+
+// Keep extra balls in play to stress physics and rendering. Balls lost
+// are replaced by new ones.
+// balls: number of extra balls, 0 to CONFIG_MAX_BALLS (0 for off).
+void game_stress(uint32_t balls);
+
+// Limit the particles of brick-break effects, e.g. to scale the density
+// with governor_effect_scale().
+// cap: most particles in use, 0 to CONFIG_MAX_PARTICLES.
+void game_particle_cap(uint32_t cap);
+
+// Add a consumer of game events (see event.h). game_tick() pushes every
+// event to the ring, and the consumer pops them from any one task.
+// ring: initialized ring, owned by the consumer.
+// Return zero if successful, or non-zero if there are too many consumers.
+int32_t game_events(event_ring_t *ring);
+
+// Play the sound for an event, if it has one (for a sound consumer).
+void game_sound(const event_t *e);
+
+// Set the input of the next step to play the game with the autoplay bot
+// (see autoplay.h). Pass to input_set_bot().
+void game_autoplay(input_t *in);
+
+// Copy the current state of the game objects for drawing. The bricks
+// changed since the last snapshot are marked dirty in the copy only, so
+// every snapshot must be drawn, or passed to game_skip().
+// frame: pointer to the state filled in by the call.
+void game_snapshot(game_frame_t *frame);
+
+// Carry the changes of a snapshot that won't be drawn into a later one.
+// frame: the later snapshot; skipped: the snapshot not drawn.
+void game_skip(game_frame_t *frame, const game_frame_t *skipped);
+
+// Draw the game objects and statistics from a snapshot (once per frame).
+// frame: pointer to the state from game_snapshot().
+void game_draw(game_frame_t *frame);
+
+// Draw the objects but the platform from a snapshot (game_draw() is this,
+// game_draw_stats() and game_draw_platform()).
+void game_draw_scene(game_frame_t *frame);
+
+// Draw the statistics text of a snapshot (can be skipped to save time).
+void game_draw_stats(game_frame_t *frame);
+
+// Draw the platform of a snapshot. Drawn after the rest of the frame, it
+// can be moved to newer input first (see platform_latch()).
+void game_draw_platform(game_frame_t *frame);
 
 #endif // GAME_H_
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+#include "lcd.h"
+#include "governor.h"
+
+#define DOWN_WINDOW 8     // Frames per overload window
+#define DOWN_OVERRUNS 2   // Overloaded frames in a window to step down
+#define DOWN_FRAC 0.90f   // Frame time above this fraction of budget is overloaded
+#define UP_FRAC 0.45f     // Frame time below this fraction of budget is slack
+#define UP_WINDOW 64      // Slack frames in a row to step up
+#define UP_WINDOW_MAX 1024
+#define HOLD_FRAMES 16    // Frames to settle after a change before judging
+
+static const char *TAG = "governor";
+
+static gov_level_t level;
+static uint32_t budget;     // Frame budget in us
+static uint32_t frames;     // Frames in the current overload window
+static uint32_t overloads;  // Overloaded frames in the current window
+static uint32_t slack;      // Slack frames in a row
+static uint32_t up_window;  // Slack frames needed to step up
+static uint32_t hold;       // Frames left to settle
+static uint32_t since_up;   // Frames since the last step up
+
+/************************ Helper Functions *************************/
+static void set_level(gov_level_t l)
+{
+    level = l;
+    lcd_setPresentMode((level >= GOV_INTERLACED) ? PRESENT_INTERLACED : PRESENT_FULL);
+    frames = overloads = slack = 0;
+    hold = HOLD_FRAMES;
+    ESP_LOGI(TAG, "level %d", (int)level);
+}
+
+/************************ Initialization *************************/
+void governor_init(uint32_t budget_us)
+{
+    budget = budget_us;
+    up_window = UP_WINDOW;
+    since_up = UINT32_MAX;
+    set_level(GOV_FULL);
+}
+
+/************************ Update Function *************************/
+void governor_frame(uint32_t frame_us, uint32_t overruns)
+{
+    // A level that held for a long time after stepping up resets the wait
+    if (since_up < UINT32_MAX && ++since_up == UP_WINDOW_MAX) up_window = UP_WINDOW;
+    if (hold) {hold--; return;}
+
+    // Step down quickly when frames overrun
+    bool over = overruns || frame_us > budget * DOWN_FRAC;
+    if (over) overloads++;
+    if (overloads >= DOWN_OVERRUNS && level < GOV_LEVELS-1) {
+        // A level that failed soon after stepping up waits longer next time
+        if (since_up < UP_WINDOW && up_window < UP_WINDOW_MAX) up_window *= 2;
+        set_level(level+1);
+        return;
+    }
+    if (++frames >= DOWN_WINDOW) frames = overloads = 0;
+
+    // Step up slowly after a run of frames with plenty of slack
+    if (!over && frame_us < budget * UP_FRAC) slack++;
+    else slack = 0;
+    if (slack >= up_window && level > GOV_FULL) {
+        since_up = 0;
+        set_level(level-1);
+    }
+}
+
+/************************ Status Functions *************************/
+gov_level_t governor_level(void)
+{
+    return level;
+}
+
+bool governor_hud(void)
+{
+    return level < GOV_NO_HUD;
+}
+
+float governor_effect_scale(void)
+{
+    return (level >= GOV_LOW_FX) ? 0.5f : 1.0f;
+}
@@ -0,0 +1,49 @@
+#ifndef GOVERNOR_H_
+#define GOVERNOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The governor trades display quality for a steady tick rate. It watches
+// the render time of each frame against the frame budget, and counts
+// overruns (missed timer ticks and skipped frames). When frames overrun,
+// it steps down one quality level. When frames have had plenty of slack
+// for a while, it steps back up. A level that fails soon after stepping up
+// must wait longer before the next try, so the governor does not
+// oscillate between two levels.
+
+// Quality levels, from best to cheapest. Each level includes the savings
+// of the levels above it.
+// Interlacing comes last: a field is half of the whole frame, which is
+// more than the dirty areas of most frames, so it only pays off when a
+// frame changes most of the screen (see present() in main.c).
+typedef enum {
+    GOV_FULL,       // Dirty areas presented, everything drawn
+    GOV_NO_HUD,     // Skip the stats text and the telemetry overlay
+    GOV_LOW_FX,     // Halve the density of effects
+    GOV_INTERLACED, // Interlaced present of frames that change over half
+                    // the screen (half the SPI bytes of those frames)
+    GOV_LEVELS
+} gov_level_t;
+
+// Initialize the governor at full quality.
+// budget_us: frame budget (timer period) in microseconds.
+void governor_init(uint32_t budget_us);
+
+// Report a rendered frame and apply any change of level.
+// Call from the render task after the frame is presented.
+// frame_us: time to draw and present the frame in microseconds.
+// overruns: missed ticks and skipped frames since the last call.
+void governor_frame(uint32_t frame_us, uint32_t overruns);
+
+// Get the current quality level.
+gov_level_t governor_level(void);
+
+// Return true if the HUD (stats text and telemetry overlay) should be
+// drawn.
+bool governor_hud(void);
+
+// Get the scale (0 to 1) for the number of effects (particles, etc.).
+float governor_effect_scale(void);
+
+#endif // GOVERNOR_H_
@@ -0,0 +1,260 @@
+// Ball-brick collision benchmark on a host (Linux).
+// Builds brick grids of increasing size, queries many ball positions per
+// tick with bricks_find, and reports the time per query next to a scan of
+// every brick. The grid query should stay flat as the grid grows. Every
+// query is checked against the scan, and the alive bricks visited by the
+// iterator against the alive count. A mismatch fails.
+//
+// Swept queries (bricks_sweep) are timed and checked against a sweep of
+// every brick the same way. A ball fired up into the grid faster than a
+// screen per step must stop at the bottom row without tunneling.
+//
+// Usage: brick_bench [-r reps]
+//   -r reps  Ticks timed for each grid size (default 2000).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h> // rand, srand
+#include <time.h> // clock_gettime
+#include <unistd.h> // getopt
+
+#include "lcd.h"
+#include "ball.h"
+#include "brick.h"
+#include "collide.h"
+
+#define NS_SEC 1000000000LL
+#define REPS 2000
+
+#define BALLS 64   // Balls queried per tick
+#define RADIUS 3   // Ball radius
+#define PHYS_RADIUS phys_from_int(RADIUS)
+#define REACH 40   // Largest motion of a swept query in pixels
+#define SHOT_SPEED 1000 // Speed of a ball fired into the grid (pixels/step)
+#define SEED 1
+
+typedef struct {
+	int rows, cols, spacing;
+} layout_t;
+
+static const layout_t layouts[] = {
+	{ 4, 10, 6}, // Game layout
+	{ 8, 12, 4},
+	{16, 24, 2},
+	{32, 48, 1},
+	{64, 64, 1},
+};
+#define NUM_LAYOUTS (sizeof(layouts)/sizeof(layouts[0]))
+
+static brick_grid_t grid;
+static phys_t bx[BALLS], by[BALLS];
+static phys_t bmx[BALLS], bmy[BALLS]; // Motion of swept queries
+
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NS_SEC + ts.tv_nsec;
+}
+
+// Reference: test every alive brick in row-major order.
+static bool scan(phys_t x, phys_t y, phys_t radius, int *row, int *col)
+{
+	for (int r = 0; r < grid.rows; r++) {
+		for (int c = 0; c < grid.cols; c++) {
+			if (!bricks_is_alive(&grid, r, c)) continue;
+			phys_t bx, by, bw, bh;
+			bricks_get_box(&grid, r, c, &bx, &by, &bw, &bh);
+			phys_t dx = x - phys_clamp(x, bx, bx+bw);
+			phys_t dy = y - phys_clamp(y, by, by+bh);
+			if (phys_mul2(dx, dx) + phys_mul2(dy, dy) <= phys_mul2(radius, radius)) {
+				*row = r; *col = c;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Reference: sweep against every alive brick, earliest in row-major order.
+static bool sweep_all(phys_t x, phys_t y, phys_t mx, phys_t my, phys_t radius,
+	phys_t *t, int *row, int *col)
+{
+	bool found = false;
+	for (int r = 0; r < grid.rows; r++) {
+		for (int c = 0; c < grid.cols; c++) {
+			if (!bricks_is_alive(&grid, r, c)) continue;
+			phys_t bx, by, bw, bh, ht, nx, ny;
+			bricks_get_box(&grid, r, c, &bx, &by, &bw, &bh);
+			if (collide_sweep_box(x, y, mx, my, radius, bx, by, bw, bh,
+					&ht, &nx, &ny) && (!found || ht < *t)) {
+				found = true;
+				*t = ht; *row = r; *col = c;
+			}
+		}
+	}
+	return found;
+}
+
+// Fire balls straight up into a full grid, one step each. The gaps are
+// narrower than the ball, so it must destroy bricks of the bottom row
+// only, however far one step would carry it.
+// Return the number of balls that tunneled.
+static uint32_t shoot(const layout_t *l)
+{
+	uint32_t bad = 0;
+	for (int i = 0; i < BALLS; i++) {
+		bricks_init_layout(&grid, l->rows, l->cols, l->spacing, l->spacing, grid.brick_h);
+		ball_t ball;
+		ball_init(&ball);
+		ball.x = phys_from_int(RADIUS + rand() % (LCD_W - 2*RADIUS));
+		ball.y = phys_from_int(LCD_H - RADIUS - 1);
+		ball.dx = 0;
+		ball.dy = phys_from_int(-SHOT_SPEED);
+		// Platform out of the way
+		uint32_t n = collide_move_ball(&ball, PHYS_ONE, &grid,
+			0, phys_from_int(2*LCD_H), PHYS_ONE, PHYS_ONE).bricks;
+		uint32_t bottom = 0;
+		for (int c = 0; c < grid.cols; c++)
+			bottom += !bricks_is_alive(&grid, grid.rows-1, c);
+		if (!n || bottom != n) bad++;
+	}
+	return bad;
+}
+
+// Build a grid filling the top two thirds of the screen with about a
+// quarter of the bricks destroyed.
+static void setup(const layout_t *l)
+{
+	phys_t h = phys_from_int(LCD_H*2/3 - (l->rows+1)*l->spacing) / l->rows;
+	if (h < PHYS_ONE) h = PHYS_ONE;
+	bricks_init_layout(&grid, l->rows, l->cols, l->spacing, l->spacing, h);
+	for (int r = 0; r < grid.rows; r++)
+		for (int c = 0; c < grid.cols; c++)
+			if (!(rand() & 3)) bricks_destroy(&grid, r, c);
+}
+
+// Place the balls at random over the grid area and below it.
+static void place_balls(void)
+{
+	for (int i = 0; i < BALLS; i++) {
+		bx[i] = phys_from_int(rand() % LCD_W);
+		by[i] = phys_from_int(rand() % LCD_H);
+		bmx[i] = phys_from_int(rand() % (2*REACH+1) - REACH);
+		bmy[i] = phys_from_int(rand() % (2*REACH+1) - REACH);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t reps = REPS;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:")) != -1) {
+		switch (opt) {
+		case 'r': reps = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-r reps]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (reps < 1) reps = 1;
+
+	srand(SEED);
+	uint32_t fail = 0;
+	printf("brick_grid_t: %zu bytes (max %dx%d)\n",
+		sizeof(brick_grid_t), MAX_BRICK_ROWS, MAX_BRICK_COLS);
+	printf("%-8s %8s %10s %10s %8s %10s %10s %8s\n",
+		"grid", "bricks", "find ns", "scan ns", "hits",
+		"sweep ns", "all ns", "tunnels");
+	for (size_t i = 0; i < NUM_LAYOUTS; i++) {
+		const layout_t *l = &layouts[i];
+		setup(l);
+
+		// The iterator visits each alive brick once, in order.
+		brick_iter_t it = bricks_iter(&grid);
+		uint32_t n = 0;
+		int r, c, last = -1;
+		while (bricks_next(&it, &r, &c)) {
+			if (!bricks_is_alive(&grid, r, c) || r*grid.cols + c <= last) fail++;
+			last = r*grid.cols + c;
+			n++;
+		}
+		if (n != bricks_get_alive_count(&grid)) {
+			fprintf(stderr, "%dx%d: iterated %lu of %lu bricks\n", l->rows, l->cols,
+				(unsigned long)n, (unsigned long)bricks_get_alive_count(&grid));
+			fail++;
+		}
+
+		// Untimed pass checks the grid query against the scan.
+		uint32_t hits = 0;
+		for (int32_t t = 0; t < reps; t++) {
+			place_balls();
+			for (int b = 0; b < BALLS; b++) {
+				int r0 = -1, c0 = -1, r1 = -1, c1 = -1;
+				bool f = bricks_find(&grid, bx[b], by[b], PHYS_RADIUS, &r0, &c0);
+				bool s = scan(bx[b], by[b], PHYS_RADIUS, &r1, &c1);
+				if (f != s || r0 != r1 || c0 != c1) {
+					if (!fail++)
+						fprintf(stderr, "%dx%d: mismatch at (%.0f,%.0f)\n",
+							l->rows, l->cols, phys_to_float(bx[b]), phys_to_float(by[b]));
+				}
+				hits += f;
+
+				phys_t t0 = -1, t1 = -1;
+				f = bricks_sweep(&grid, bx[b], by[b], bmx[b], bmy[b], PHYS_RADIUS,
+					&t0, &r0, &c0, &(phys_t){0}, &(phys_t){0});
+				s = sweep_all(bx[b], by[b], bmx[b], bmy[b], PHYS_RADIUS, &t1, &r1, &c1);
+				if (f != s || (f && (t0 != t1 || r0 != r1 || c0 != c1))) {
+					if (!fail++)
+						fprintf(stderr, "%dx%d: sweep mismatch at (%.0f,%.0f)+(%.0f,%.0f)\n",
+							l->rows, l->cols, phys_to_float(bx[b]), phys_to_float(by[b]),
+							phys_to_float(bmx[b]), phys_to_float(bmy[b]));
+				}
+			}
+		}
+
+		// Same positions for both timed loops.
+		place_balls();
+		volatile uint32_t sink = 0;
+		int64_t start = now_ns();
+		for (int32_t t = 0; t < reps; t++)
+			for (int b = 0; b < BALLS; b++)
+				sink += bricks_find(&grid, bx[b], by[b], PHYS_RADIUS, &r, &c);
+		int64_t find = now_ns() - start;
+		start = now_ns();
+		for (int32_t t = 0; t < reps; t++)
+			for (int b = 0; b < BALLS; b++)
+				sink += scan(bx[b], by[b], PHYS_RADIUS, &r, &c);
+		int64_t brute = now_ns() - start;
+		phys_t t, nx, ny;
+		start = now_ns();
+		for (int32_t t0 = 0; t0 < reps; t0++)
+			for (int b = 0; b < BALLS; b++)
+				sink += bricks_sweep(&grid, bx[b], by[b], bmx[b], bmy[b], PHYS_RADIUS,
+					&t, &r, &c, &nx, &ny);
+		int64_t sweep = now_ns() - start;
+		start = now_ns();
+		for (int32_t t0 = 0; t0 < reps; t0++)
+			for (int b = 0; b < BALLS; b++)
+				sink += sweep_all(bx[b], by[b], bmx[b], bmy[b], PHYS_RADIUS, &t, &r, &c);
+		int64_t sweep_brute = now_ns() - start;
+		(void)sink;
+
+		uint32_t tunnels = l->spacing < 2*RADIUS ? shoot(l) : 0;
+		fail += tunnels;
+
+		char name[16];
+		snprintf(name, sizeof(name), "%dx%d", l->rows, l->cols);
+		printf("%-8s %8d %10.1f %10.1f %8lu %10.1f %10.1f %8lu\n",
+			name, grid.rows*grid.cols,
+			(double)find/reps/BALLS, (double)brute/reps/BALLS,
+			(unsigned long)hits,
+			(double)sweep/reps/BALLS, (double)sweep_brute/reps/BALLS,
+			(unsigned long)tunnels);
+	}
+	if (fail) fprintf(stderr, "%lu failed checks\n", (unsigned long)fail);
+	return fail != 0;
+}
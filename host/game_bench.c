@@ -0,0 +1,270 @@
+// Game benchmark on a host (Linux).
+// Plays whole games headless at full speed with a bot at the controls and
+// reports the physics steps (ticks) per second and the cost of each game
+// function called by the main loop. Drawing goes to the recording LCD
+// backend (lcd_rec.h) and sound to the null driver, so only the game code
+// is measured. Run it under perf for the functions inside game_tick.
+//
+// A game starts with game_restart() and ends when the ball is lost, the
+// round is cleared or the step limit is reached. The bot keeps the
+// platform under the ball, aiming at an offset that differs from game to
+// game, so the games differ but every run plays the same games. With
+// -a, the autoplay bot (autoplay.h) plays instead: it predicts where the
+// ball comes down and clears rounds, for soak tests of every game state.
+// A frame is drawn every FRAME_STEPS steps, and the hash of the drawing
+// calls (which covers the game state) is compared with a reference.
+// Every frame the game is saved and restored (game_save, game_load),
+// which must not change it, to time snapshots; game_restart restores the
+// state saved by the first game. Game events are drained after each step
+// and played by the sound consumer (game_sound), as the sound task does
+// on the device.
+//
+// Usage: game_bench [-g games] [-s steps] [-a] [-u] [-n]
+//   -g games  Games to play (default 500).
+//   -s steps  Step limit per game (default 12000, one minute).
+//   -a        Play with the autoplay bot.
+//   -u        Print the checksum for updating the reference.
+//   -n        Don't compare with the reference.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h> // atoi
+#include <time.h> // clock_gettime
+#include <unistd.h> // getopt
+
+#include "hw.h"
+#include "lcd.h"
+#include "lcd_rec.h"
+#include "sound_null.h"
+#include "render.h"
+#include "pin.h"
+#include "joy.h"
+#include "input.h"
+#include "event.h"
+#include "phys.h"
+#include "game.h"
+#include "config.h"
+
+#define NS_SEC 1000000000LL
+#define GAMES 500
+#define STEPS 12000
+#define FRAME_STEPS 8 // Physics steps per drawn frame
+#define AIM_RANGE 81  // Bot aim offsets, pixels centered on zero
+#define CAL_REPS 10000 // Timer calls to measure the timer cost
+
+// Reference checksum with the default games and steps
+#define REF_SUM 0x1ec36ea2u
+
+extern ball_t game_ball;
+extern platform_t game_platform;
+extern brick_grid_t game_bricks;
+
+// Timed game functions
+enum {
+	F_RESTART,  // game_restart
+	F_INPUT,    // input_tick
+	F_TICK,     // game_tick
+	F_EVENTS,   // event_pop and game_sound
+	F_SNAPSHOT, // game_snapshot
+	F_SAVE,     // game_save
+	F_LOAD,     // game_load
+	F_CLEAR,    // render_begin
+	F_DRAW,     // game_draw
+	F_NUM
+};
+static const char *const f_names[F_NUM] =
+	{"game_restart", "input_tick", "game_tick", "game_sound", "game_snapshot",
+	 "game_save", "game_load", "render_begin", "game_draw"};
+
+static int64_t f_ns[F_NUM];
+static uint64_t f_calls[F_NUM];
+static int64_t timer_ns; // Cost of a now_ns() call, taken off each time
+static int32_t aim;      // Bot aim offset of this game in pixels
+static event_ring_t events;
+
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NS_SEC + ts.tv_nsec;
+}
+
+// Charge the time since t to a function. Return the time now.
+static int64_t charge(int32_t f, int64_t t)
+{
+	int64_t n = now_ns();
+	f_ns[f] += n - t - timer_ns;
+	f_calls[f]++;
+	return n;
+}
+
+/************************ Bot *************************/
+// The A button is held (active low), so a new ball launches at once.
+int32_t pin_get_level(pin_num_t pin)
+{
+	return pin != HW_BTN_A;
+}
+
+// Steer the platform center to the ball plus the aim offset
+void joy_get_displacement(int32_t *dcx, int32_t *dcy)
+{
+	int32_t px = phys_floor(game_platform.x + game_platform.width/2);
+	int32_t d = (phys_floor(game_ball.x) + aim - px) * (JOY_MAX_DISP/16);
+	if (d > JOY_MAX_DISP) d = JOY_MAX_DISP;
+	if (d < -JOY_MAX_DISP) d = -JOY_MAX_DISP;
+	*dcx = d;
+	*dcy = 0;
+}
+
+// Autoplay bot, pushed off by the aim offset so the games differ
+static void autoplay_bot(input_t *in)
+{
+	game_autoplay(in);
+	int32_t d = in->joy_x + aim * (JOY_MAX_DISP/64);
+	if (d > JOY_MAX_DISP) d = JOY_MAX_DISP;
+	if (d < -JOY_MAX_DISP) d = -JOY_MAX_DISP;
+	in->joy_x = d;
+}
+
+/************************ Games *************************/
+// Game results
+enum {
+	G_WON,   // Round cleared
+	G_LOST,  // Ball lost
+	G_LIMIT, // Step limit reached
+	G_NUM
+};
+
+// Play one game. Return the result, and the steps run in *steps.
+static int32_t play(int32_t limit, int32_t *steps)
+{
+	const phys_t dt = PHYS(CONFIG_PHYSICS_STEP);
+	static game_frame_t frame;
+	static game_state_t state;
+	int32_t i, res = G_LIMIT;
+
+	int64_t t = now_ns();
+	game_restart();
+	charge(F_RESTART, t);
+	input_init();
+	for (i = 0; i < limit; ) {
+		uint32_t alive = bricks_get_alive_count(&game_bricks);
+		t = now_ns();
+		input_tick();
+		t = charge(F_INPUT, t);
+		game_tick(dt);
+		t = charge(F_TICK, t);
+		event_t e;
+		while (event_pop(&events, &e))
+			game_sound(&e);
+		t = charge(F_EVENTS, t);
+		i++;
+		if (!(i % FRAME_STEPS)) {
+			game_snapshot(&frame);
+			t = charge(F_SNAPSHOT, t);
+			game_save(&state);
+			t = charge(F_SAVE, t);
+			game_load(&state);
+			t = charge(F_LOAD, t);
+			render_begin();
+			t = charge(F_CLEAR, t);
+			game_draw(&frame);
+			charge(F_DRAW, t);
+		}
+		if (ball_is_lost(&game_ball)) {
+			res = G_LOST;
+			break;
+		}
+		// game_tick starts the next round at once
+		if (bricks_get_alive_count(&game_bricks) > alive) {
+			res = G_WON;
+			break;
+		}
+	}
+	*steps = i;
+	return res;
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t games = GAMES;
+	int32_t limit = STEPS;
+	bool autoplay = false;
+	bool update = false;
+	bool nocmp = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "g:s:aun")) != -1) {
+		switch (opt) {
+		case 'g': games = atoi(optarg); break;
+		case 's': limit = atoi(optarg); break;
+		case 'a': autoplay = true; break;
+		case 'u': update = true; break;
+		case 'n': nocmp = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-g games] [-s steps] [-a] [-u] [-n]\n",
+				argv[0]);
+			return 2;
+		}
+	}
+	if (games < 1) games = 1;
+	if (limit < 1) limit = 1;
+
+	// Cost of reading the timer
+	int64_t t0 = now_ns();
+	for (int32_t i = 0; i < CAL_REPS; i++) now_ns();
+	timer_ns = (now_ns() - t0) / CAL_REPS;
+
+	lcd_init();
+	render_init(CONFIG_COLOR_BACKGROUND);
+	lcd_rec_resetStats();
+	sound_null_resetStarts();
+	event_init(&events);
+	game_events(&events);
+	if (autoplay) input_set_bot(autoplay_bot);
+
+	uint32_t results[G_NUM] = {0};
+	int64_t steps = 0;
+	t0 = now_ns();
+	for (int32_t g = 0; g < games; g++) {
+		int32_t n;
+		aim = g % AIM_RANGE - AIM_RANGE/2;
+		results[play(limit, &n)]++;
+		steps += n;
+	}
+	int64_t diff = now_ns() - t0;
+
+	lcd_rec_stats_t draw;
+	lcd_rec_getStats(&draw);
+	uint64_t frames = f_calls[F_DRAW] ? f_calls[F_DRAW] : 1;
+
+#ifdef CONFIG_PHYSICS_FLOAT
+	const char *kind = "float";
+#else
+	const char *kind = "Q16.16";
+#endif
+	printf("%s physics: %ld games, %lld steps, won %lu, lost %lu, %lu at the step limit\n",
+		kind, (long)games, (long long)steps, (unsigned long)results[G_WON],
+		(unsigned long)results[G_LOST], (unsigned long)results[G_LIMIT]);
+	printf("%.0f ticks/s (whole loop), %.1f s of play per game\n",
+		(double)steps * NS_SEC / diff,
+		steps * CONFIG_PHYSICS_STEP / games);
+	printf("game_state_t: %zu bytes\n", sizeof(game_state_t));
+	printf("%-14s %10s %10s\n", "function", "calls", "ns/call");
+	for (int32_t f = 0; f < F_NUM; f++)
+		printf("%-14s %10llu %10.1f\n", f_names[f],
+			(unsigned long long)f_calls[f],
+			f_calls[f] ? (double)f_ns[f] / f_calls[f] : 0.0);
+	printf("drawing: %.1f calls/frame, %.0f pixels/frame; %.1f sounds/game; checksum 0x%08lx\n",
+		(double)draw.calls / frames, (double)draw.pixels / frames,
+		(double)sound_null_getStarts() / games, (unsigned long)draw.sum);
+	if (update) printf("#define REF_SUM 0x%08lxu\n", (unsigned long)draw.sum);
+	if (!nocmp && !autoplay && games == GAMES && limit == STEPS && draw.sum != REF_SUM) {
+		fprintf(stderr, "checksum 0x%08lx, expected 0x%08lx\n",
+			(unsigned long)draw.sum, (unsigned long)REF_SUM);
+		return 1;
+	}
+	return 0;
+}
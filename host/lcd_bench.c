@@ -0,0 +1,554 @@
+// Rendering micro-benchmarks for the LCD component on a host (Linux).
+// Runs the lcd_test scenarios against the virtual panel (lcd_host.c),
+// reports the time per drawing call and the bus traffic, and compares a
+// checksum of the panel contents with a reference so a change to the
+// rasterizer that alters the image fails.
+//
+// Usage: lcd_bench [-r reps] [-w dir] [-u] [-n]
+//   -r reps  Repetitions of each timed scenario (default 20).
+//   -w dir   Write a PPM snapshot of each scenario to dir.
+//   -u       Print the checksum table for updating the reference.
+//   -n       Don't compare with the reference (other display targets).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h> // rand, srand, malloc
+#include <string.h> // strlen
+#include <time.h> // clock_gettime
+#include <unistd.h> // getopt
+
+#include "lcd.h"
+#include "lcd_host.h"
+#include "crosshair.h"
+#include "peppers.h"
+
+#define NS_SEC 1000000000LL
+#define REPS 20
+
+#define RAND_COLOR() ((color_t)rand())
+#define SEED 1
+
+typedef struct {
+	const char *name;
+	void (*setup)(void);   // Untimed preparation
+	uint32_t (*draw)(void); // Timed, returns the number of drawing calls
+	bool frame_only;       // Needs the frame buffer
+	uint32_t sum;          // Reference panel checksum
+} scenario_t;
+
+static const coord_t width = LCD_W;
+static const coord_t height = LCD_H;
+
+static uint16_t *peppers_rle; // Posterized peppers image, RLE packets
+
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NS_SEC + ts.tv_nsec;
+}
+
+// Encode w*h colors into RLE packets (see lcd_drawImageRLE).
+// Returns the number of words written to out.
+static size_t rle_encode(uint16_t *out, const color_t *img, size_t len)
+{
+	size_t o = 0, i = 0, lit = 0; // lit: start of pending literal
+	while (i < len) {
+		size_t n = 1;
+		while (i+n < len && img[i+n] == img[i] && n < LCD_RLE_CNT) n++;
+		if (n >= 3 || i+n == len) {
+			while (lit < i) { // flush literal
+				size_t m = i-lit < LCD_RLE_CNT ? i-lit : LCD_RLE_CNT;
+				out[o++] = m;
+				for (; m; m--) out[o++] = img[lit++];
+			}
+			if (n < 3) {
+				out[o++] = n;
+				for (size_t k = 0; k < n; k++) out[o++] = img[i];
+			} else {
+				out[o++] = LCD_RLE_RUN | n;
+				out[o++] = img[i];
+			}
+			lit = i += n;
+		} else {
+			i += n;
+		}
+	}
+	return o;
+}
+
+//----------------------------------------------------------------------------//
+// Setup
+//----------------------------------------------------------------------------//
+
+static void clear_black(void) {lcd_fillScreen(BLACK);}
+static void clear_cyan(void) {lcd_fillScreen(CYAN);}
+static void clear_blue(void) {lcd_fillScreen(rgb565(4, 16, 64));}
+static void load_peppers(void) {lcd_drawRGBBitmap(0, 0, peppers, PEPPERS_W, PEPPERS_H);}
+
+// Clear the panel, then load the frame buffer without presenting it.
+static void blank_peppers(void)
+{
+	lcd_fillScreen(BLACK);
+	lcd_writeFrame();
+	load_peppers();
+}
+
+//----------------------------------------------------------------------------//
+// Scenarios (see lcd_test.c)
+//----------------------------------------------------------------------------//
+
+static uint32_t colorBar(void)
+{
+	coord_t x1 = width/3, x2 = width*2/3;
+	lcd_fillRect( 0, 0,    x1   , height, RED);
+	lcd_fillRect(x1, 0,    x2-x1, height, GREEN);
+	lcd_fillRect(x2, 0, width-x2, height, BLUE);
+	return 3;
+}
+
+static uint32_t colorBand(void)
+{
+	color_t color = RED;
+	coord_t delta = height/16;
+	coord_t ypos = 0;
+	for (int32_t i = 0; i < 16; i++) {
+		lcd_fillRect(0, ypos, width, delta, color);
+		color = color >> 1;
+		ypos += delta;
+	}
+	return 16;
+}
+
+static uint32_t fillScreen(void)
+{
+	color_t ctab[] = {RED,GREEN,BLUE,BLACK,GRAY,YELLOW,CYAN,MAGENTA};
+	for (int32_t i = 0; i < 16; i++) lcd_fillScreen(ctab[i%8]);
+	return 16;
+}
+
+static uint32_t drawHVLine(void)
+{
+	uint32_t n = 0;
+	for (coord_t ypos = 0; ypos < height; ypos += 10, n++)
+		lcd_drawHLine(0, ypos, width, RED);
+	for (coord_t xpos = 0; xpos < width; xpos += 10, n++)
+		lcd_drawVLine(xpos, 0, height, RED);
+	return n;
+}
+
+static uint32_t drawLine(void)
+{
+	srand(SEED);
+	for (int32_t i = 0; i < 100; i++) {
+		coord_t x0 = rand() % width;
+		coord_t y0 = rand() % height;
+		coord_t x1 = rand() % width;
+		coord_t y1 = rand() % height;
+		lcd_drawLine(x0, y0, x1, y1, RAND_COLOR());
+	}
+	return 100;
+}
+
+static uint32_t drawRect(void)
+{
+	coord_t limit = (width > height ? height : width) / 2;
+	uint32_t n = 0;
+	for (coord_t i = 0; i < limit; i += 5, n++)
+		lcd_drawRect(i, i, width-2*i, height-2*i, GREEN);
+	return n;
+}
+
+static uint32_t fillRect(void)
+{
+	srand(SEED);
+	for (int32_t i = 0; i < 100; i++) {
+		coord_t xpos = rand() % width;
+		coord_t ypos = rand() % height;
+		coord_t size = rand() % (width/5)+1;
+		lcd_fillRect(xpos, ypos, size, size, RAND_COLOR());
+	}
+	return 100;
+}
+
+static uint32_t drawTriangle(void)
+{
+	srand(SEED);
+	for (int32_t i = 0; i < 100; i++) {
+		coord_t x0 = rand() % width, y0 = rand() % height;
+		coord_t x1 = rand() % width, y1 = rand() % height;
+		coord_t x2 = rand() % width, y2 = rand() % height;
+		lcd_drawTriangle(x0, y0, x1, y1, x2, y2, RAND_COLOR());
+	}
+	return 100;
+}
+
+static uint32_t fillTriangle(void)
+{
+	srand(SEED);
+	for (int32_t i = 0; i < 100; i++) {
+		coord_t x0 = rand() % width, y0 = rand() % height;
+		coord_t x1 = rand() % width, y1 = rand() % height;
+		coord_t x2 = rand() % width, y2 = rand() % height;
+		lcd_fillTriangle(x0, y0, x1, y1, x2, y2, RAND_COLOR());
+	}
+	return 100;
+}
+
+static uint32_t drawCircle(void)
+{
+	coord_t limit = (height < width ? height : width) / 2;
+	uint32_t n = 0;
+	for (coord_t i = 5; i < limit; i += 5, n++)
+		lcd_drawCircle(width/2, height/2, i, CYAN);
+	return n;
+}
+
+static uint32_t fillCircle(void)
+{
+	srand(SEED);
+	for (int32_t i = 0; i < 100; i++) {
+		coord_t radius = rand() % (width/5);
+		coord_t xpos = rand() % width;
+		if (xpos < radius) xpos = radius; // clip
+		else if (xpos > width-1-radius) xpos = width-1-radius;
+		coord_t ypos = rand() % height;
+		if (ypos < radius) ypos = radius; // clip
+		else if (ypos > height-1-radius) ypos = height-1-radius;
+		lcd_fillCircle(xpos, ypos, radius, RAND_COLOR());
+	}
+	return 100;
+}
+
+static uint32_t drawRoundRect(void)
+{
+	coord_t limit = (width > height ? height : width) / 2;
+	uint32_t n = 0;
+	for (coord_t i = 0; i < limit; i += 5, n++)
+		lcd_drawRoundRect(i, i, width-2*i, height-2*i, 30, YELLOW);
+	return n;
+}
+
+static uint32_t fillRoundRect(void)
+{
+	color_t ctab[] = {YELLOW,rgb565(4, 16, 64)};
+	coord_t limit = (width > height ? height : width) / 2;
+	uint32_t n = 0;
+	for (coord_t i = 0; i < limit; i += 5, n++)
+		lcd_fillRoundRect(i, i, width-2*i, height-2*i, 30, ctab[n%2]);
+	return n;
+}
+
+static uint32_t drawArrow(void)
+{
+	uint32_t n = 0;
+	for (coord_t x1 = 0; x1 < width; x1 += 20, n++)
+		lcd_drawArrow(width/2, height/2, x1, 0, 5, WHITE);
+	return n;
+}
+
+static uint32_t fillArrow(void)
+{
+	lcd_fillArrow(15, 15, 0, 0, 5, RED);
+	lcd_fillArrow(width-1-15, 15, width-1, 0, 5, GREEN);
+	lcd_fillArrow(15, height-1-15, 0, height-1, 5, GRAY);
+	lcd_fillArrow(width-1-15, height-1-15, width-1, height-1, 5, CYAN);
+	return 4;
+}
+
+static uint32_t drawBitmap(void)
+{
+	color_t ctab[] = {RED,GREEN,BLUE,BLACK,GRAY,YELLOW,CYAN,MAGENTA};
+	uint32_t n = 0;
+	for (coord_t y = 0; y < LCD_H; y += CROSSHAIR_H+1) {
+		coord_t x;
+		uint8_t c;
+		for (x = 0, c = 0; x < LCD_W; x += CROSSHAIR_W+1, c++, n++)
+			lcd_drawBitmap(x, y, crosshair, CROSSHAIR_W, CROSSHAIR_H, ctab[c%8]);
+	}
+	return n;
+}
+
+static uint32_t drawRGBBitmap(void)
+{
+	coord_t x = 0, y = 0;
+	for (; y < 10; y++) lcd_drawRGBBitmap(x, y, peppers, PEPPERS_W, PEPPERS_H);
+	for (; x < 10; x++) lcd_drawRGBBitmap(x, y, peppers, PEPPERS_W, PEPPERS_H);
+	for (; y > 0; y--) lcd_drawRGBBitmap(x, y, peppers, PEPPERS_W, PEPPERS_H);
+	for (; x > 0; x--) lcd_drawRGBBitmap(x, y, peppers, PEPPERS_W, PEPPERS_H);
+	return 40;
+}
+
+static uint32_t drawImageRLE(void)
+{
+	lcd_drawImageRLE(0, 0, peppers_rle, PEPPERS_W, PEPPERS_H);
+	return 1;
+}
+
+static uint32_t fillRect2(void)
+{
+	srand(SEED);
+	for (int32_t i = 0; i < 100; i++) {
+		coord_t x0 = rand() % width, y0 = rand() % height;
+		coord_t x1 = rand() % width, y1 = rand() % height;
+		lcd_fillRect2(x0, y0, x1, y1, RAND_COLOR());
+	}
+	return 100;
+}
+
+static uint32_t drawRectC(void)
+{
+	coord_t h = ((height < width) ? height : width) * 0.7;
+	coord_t w = h * 0.5;
+	uint32_t n = 0;
+	for (angle_t angle = 0; angle < (360*3); angle += 30, n += 2) {
+		lcd_drawRectC(width/2, height/2, w, h, angle, CYAN);
+		lcd_drawRectC(width/2, height/2, w, h, angle, BLACK);
+	}
+	for (angle_t angle = 0; angle < 180; angle += 30, n++)
+		lcd_drawRectC(width/2, height/2, w, h, angle, CYAN);
+	return n;
+}
+
+static uint32_t drawRegularPolygonC(void)
+{
+	coord_t limit = (width > height ? height : width) / 2;
+	uint32_t n = 0;
+	for (coord_t k = 3; ; k++, n++) {
+		coord_t radius = k*15-35;
+		if (radius >= limit) break;
+		lcd_drawRegularPolygonC(width/2, height/2, k, radius, k*10, GREEN);
+	}
+	return n;
+}
+
+static uint32_t drawString(void)
+{
+	char text[] = "Carpe Diem!";
+	size_t tlen = strlen(text);
+	color_t bgtab[] = {RED,GREEN,BLUE,BLACK,GRAY,YELLOW,CYAN,MAGENTA};
+	srand(SEED);
+	lcd_setFontDirection(DIRECTION0);
+	for (int32_t i = 0; i < 100; i++) {
+		uint8_t size = (i&0x3)+1;
+		coord_t xpos = rand() % (width-LCD_CHAR_W*size*tlen+1);
+		coord_t ypos = rand() % (height-LCD_CHAR_H*size+1);
+		lcd_setFontSize(size);
+		lcd_setFontBackground(bgtab[i%8]);
+		lcd_drawString(xpos, ypos, text, RAND_COLOR());
+	}
+	lcd_noFontBackground();
+	return 100;
+}
+
+static uint32_t wrapAround(void)
+{
+	uint32_t n = 0;
+	for (coord_t i = 0; i < width/8; i++, n++) {
+		lcd_wrapAround(SCROLL_RIGHT, height/4, height/4*3-1); lcd_writeFrame();
+	}
+	for (coord_t i = 0; i < width/8; i++, n++) {
+		lcd_wrapAround(SCROLL_LEFT, height/4, height/4*3-1); lcd_writeFrame();
+	}
+	for (coord_t i = 0; i < height/8; i++, n++) {
+		lcd_wrapAround(SCROLL_DOWN, width/4, width/4*3-1); lcd_writeFrame();
+	}
+	for (coord_t i = 0; i < height/8; i++, n++) {
+		lcd_wrapAround(SCROLL_UP, width/4, width/4*3-1); lcd_writeFrame();
+	}
+	return n;
+}
+
+static uint32_t writeFrame(void)
+{
+	lcd_writeFrame();
+	return 1;
+}
+
+static uint32_t writeFrame444(void)
+{
+	lcd_setPixelFormat(FORMAT_RGB444);
+	lcd_writeFrame();
+	lcd_setPixelFormat(FORMAT_RGB565);
+	return 1;
+}
+
+// Present the frame in four rectangles of odd sizes.
+static uint32_t writeFrameRect(void)
+{
+	coord_t x = width/2+1, y = height/2-1;
+	lcd_writeFrameRect(0, 0, x, y);
+	lcd_writeFrameRect(x, 0, width-x, y);
+	lcd_writeFrameRect(0, y, x, height-y);
+	lcd_writeFrameRect(x, y, width-x, height-y);
+	return 4;
+}
+
+// Both fields of an interlaced frame, one call each.
+static uint32_t writeFrameInterlaced(void)
+{
+	lcd_setPresentMode(PRESENT_INTERLACED);
+	lcd_writeFrame();
+	lcd_writeFrame();
+	lcd_setPresentMode(PRESENT_FULL);
+	return 2;
+}
+
+static scenario_t scenarios[] = {
+	{"colorBar",            NULL,         colorBar,            false, 0xc9c44ba5},
+	{"colorBand",           clear_black,  colorBand,           false, 0x9e9891c5},
+	{"fillScreen",          NULL,         fillScreen,          false, 0x8ce67dc5},
+	{"drawHVLine",          clear_black,  drawHVLine,          false, 0x8d2a5dc5},
+	{"drawLine",            clear_black,  drawLine,            false, 0x67c088b0},
+	{"drawRect",            clear_black,  drawRect,            false, 0x16de09c5},
+	{"fillRect",            clear_cyan,   fillRect,            false, 0x3e0ce642},
+	{"drawTriangle",        clear_black,  drawTriangle,        false, 0x9ee3791d},
+	{"fillTriangle",        clear_cyan,   fillTriangle,        false, 0x4ff020d1},
+	{"drawCircle",          clear_black,  drawCircle,          false, 0x297e7885},
+	{"fillCircle",          clear_cyan,   fillCircle,          false, 0x80547287},
+	{"drawRoundRect",       clear_black,  drawRoundRect,       false, 0x60d06e25},
+	{"fillRoundRect",       clear_black,  fillRoundRect,       false, 0x4b1e1fd5},
+	{"drawArrow",           clear_black,  drawArrow,           false, 0xec2da287},
+	{"fillArrow",           clear_black,  fillArrow,           false, 0x04e48618},
+	{"drawBitmap",          clear_blue,   drawBitmap,          false, 0xf05905ff},
+	{"drawRGBBitmap",       clear_black,  drawRGBBitmap,       false, 0xb79795d1},
+	{"drawImageRLE",        clear_black,  drawImageRLE,        false, 0xe4c1592f},
+	{"fillRect2",           clear_cyan,   fillRect2,           false, 0x4f64bcec},
+	{"drawRectC",           clear_black,  drawRectC,           false, 0xd2a7a2e5},
+	{"drawRegularPolygonC", clear_black,  drawRegularPolygonC, false, 0x31deeddd},
+	{"drawString",          clear_black,  drawString,          false, 0x95a10783},
+	{"wrapAround",          load_peppers, wrapAround,          true,  0x2679adba},
+	{"writeFrame",          load_peppers, writeFrame,          true,  0x2679adba},
+	{"writeFrameInterlaced", blank_peppers, writeFrameInterlaced, true, 0x2679adba},
+	{"writeFrame444",       blank_peppers, writeFrame444,      true,  0x2679adba},
+	{"writeFrameRect",      blank_peppers, writeFrameRect,     true,  0x2679adba},
+};
+
+#define NUM_SCENARIOS (sizeof(scenarios)/sizeof(scenarios[0]))
+
+//----------------------------------------------------------------------------//
+// Checks
+//----------------------------------------------------------------------------//
+
+// Expand RGB565 through RGB444 and back, as the panel sees it.
+static color_t round_trip_444(color_t c)
+{
+	uint16_t r = c >> 12, g = (c >> 7) & 0xF, b = (c >> 1) & 0xF;
+	return (r << 1 | r >> 3) << 11 | (g << 2 | g >> 2) << 5 | (b << 1 | b >> 3);
+}
+
+// Present the peppers image in RGB444 (whole frame and a single odd pixel
+// run) and compare the panel with the expected reduced colors.
+// Returns the number of wrong pixels.
+static uint32_t check_444(void)
+{
+	lcd_frameDisable();
+	lcd_fillScreen(BLACK);
+	lcd_setPixelFormat(FORMAT_RGB444);
+	bool reduced = lcd_getPixelFormat() == FORMAT_RGB444;
+	lcd_drawRGBBitmap(0, 0, peppers, PEPPERS_W, PEPPERS_H);
+	lcd_drawHPixels(1, 0, 3, peppers+1); // odd count
+	lcd_setPixelFormat(FORMAT_RGB565);
+
+	const color_t *panel = lcd_host_getPanel();
+	uint32_t bad = 0;
+	for (coord_t y = 0; y < LCD_H && y < PEPPERS_H; y++) {
+		for (coord_t x = 0; x < LCD_W && x < PEPPERS_W; x++) {
+			color_t c = peppers[y*PEPPERS_W+x];
+			if (reduced) c = round_trip_444(c);
+			if (panel[y*LCD_W+x] != c) bad++;
+		}
+	}
+	printf("\nRGB444 %s: %s\n", reduced ? "transfer" : "fallback", bad ? "MISMATCH" : "ok");
+	return bad;
+}
+
+//----------------------------------------------------------------------------//
+// Main
+//----------------------------------------------------------------------------//
+
+int main(int argc, char *argv[])
+{
+	int32_t reps = REPS;
+	const char *dir = NULL;
+	bool update = false;
+	bool nocmp = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:w:un")) != -1) {
+		switch (opt) {
+		case 'r': reps = atoi(optarg); break;
+		case 'w': dir = optarg; break;
+		case 'u': update = true; break;
+		case 'n': nocmp = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-r reps] [-w dir] [-u] [-n]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (reps < 1) reps = 1;
+
+	// Posterize so the image has runs worth encoding.
+	static color_t poster[PEPPERS_PIXELS];
+	for (size_t i = 0; i < PEPPERS_PIXELS; i++) poster[i] = peppers[i] & 0xE71C;
+	peppers_rle = malloc(2*PEPPERS_PIXELS*sizeof(uint16_t));
+	size_t rle_len = rle_encode(peppers_rle, poster, PEPPERS_PIXELS);
+	printf("peppers RLE: %zu words (%.1f%% of raw)\n",
+		rle_len, 100.0*rle_len/PEPPERS_PIXELS);
+
+	lcd_init();
+
+	uint32_t fail = 0;
+	uint32_t got[NUM_SCENARIOS] = {0};
+	printf("%-20s %-6s %12s %12s %12s %10s\n",
+		"scenario", "mode", "ns/call", "bytes/rep", "cmds/rep", "checksum");
+	for (int32_t mode = 0; mode < 2; mode++) {
+		bool frame = mode;
+		if (frame) lcd_frameEnable();
+		for (size_t i = 0; i < NUM_SCENARIOS; i++) {
+			scenario_t *s = &scenarios[i];
+			if (s->frame_only && !frame) continue;
+			if (s->setup) s->setup();
+
+			// One untimed pass sets the checksum image.
+			uint32_t calls = s->draw();
+			lcd_writeFrame();
+			uint32_t sum = lcd_host_checksum();
+			if (!got[i]) got[i] = sum;
+			if (dir) {
+				char path[256];
+				snprintf(path, sizeof(path), "%s/%s_%s.ppm", dir, s->name, frame ? "fb" : "direct");
+				if (lcd_host_writePPM(path)) fprintf(stderr, "can't write %s\n", path);
+			}
+
+			lcd_host_resetStats();
+			int64_t start = now_ns();
+			for (int32_t r = 0; r < reps; r++) s->draw();
+			int64_t diff = now_ns() - start;
+			lcd_host_stats_t st;
+			lcd_host_getStats(&st);
+
+			// Both modes must produce the reference image.
+			bool ok = (update || nocmp ? got[i] : s->sum) == sum;
+			printf("%-20s %-6s %12.1f %12.0f %12.0f   %08x%s\n",
+				s->name, frame ? "fb" : "direct",
+				(double)diff / ((double)reps * calls),
+				(double)st.bytes / reps, (double)st.commands / reps,
+				sum, ok ? "" : " MISMATCH");
+			if (!ok) fail++;
+		}
+	}
+
+	if (check_444()) fail++;
+
+	if (update) {
+		printf("\nReference checksums:\n");
+		for (size_t i = 0; i < NUM_SCENARIOS; i++)
+			printf("\t%-22s 0x%08x\n", scenarios[i].name, got[i]);
+	}
+	if (fail) printf("\n%u scenario(s) changed the image\n", fail);
+	free(peppers_rle);
+	return fail ? 1 : 0;
+}
@@ -0,0 +1,88 @@
+// Recording LCD backend, see lcd_rec.h. Only the calls made by the game
+// code are provided.
+
+#include <stdint.h>
+#include <string.h> // strlen
+
+#include "lcd.h"
+#include "lcd_rec.h"
+
+#define FNV_INIT 0x811C9DC5u
+#define FNV_PRIME 0x01000193u
+
+// Drawing calls (first hashed word)
+enum {
+	REC_FILL_SCREEN,
+	REC_FILL_RECT,
+	REC_FILL_CIRCLE,
+	REC_STRING,
+};
+
+static lcd_rec_stats_t stats = {0, 0, FNV_INIT};
+
+
+static void hash(int32_t v)
+{
+	for (int32_t i = 0; i < 4; i++, v >>= 8)
+		stats.sum = (stats.sum ^ (uint8_t)v) * FNV_PRIME;
+}
+
+// Record a call covering the box x, y, w, h
+static void record(int32_t call, coord_t x, coord_t y, coord_t w, coord_t h,
+	color_t color)
+{
+	hash(call); hash(x); hash(y); hash(w); hash(h); hash(color);
+	stats.calls++;
+	coord_t x1 = x + w, y1 = y + h;
+	if (x < 0) x = 0;
+	if (y < 0) y = 0;
+	if (x1 > LCD_W) x1 = LCD_W;
+	if (y1 > LCD_H) y1 = LCD_H;
+	if (x1 > x && y1 > y) stats.pixels += (uint64_t)(x1 - x) * (y1 - y);
+}
+
+void lcd_rec_getStats(lcd_rec_stats_t *s)
+{
+	*s = stats;
+}
+
+void lcd_rec_resetStats(void)
+{
+	stats = (lcd_rec_stats_t){0, 0, FNV_INIT};
+}
+
+/************************ LCD Functions *************************/
+
+void lcd_init(void)
+{
+}
+
+// No frame buffer, so pixels are drawn with the recorded calls
+color_t *lcd_getFrameBuffer(void)
+{
+	return NULL;
+}
+
+void lcd_fillScreen(color_t color)
+{
+	record(REC_FILL_SCREEN, 0, 0, LCD_W, LCD_H, color);
+}
+
+void lcd_fillRect(coord_t x, coord_t y, coord_t w, coord_t h, color_t color)
+{
+	record(REC_FILL_RECT, x, y, w, h, color);
+}
+
+// Counted as the bounding box
+void lcd_fillCircle(coord_t xc, coord_t yc, coord_t r, color_t color)
+{
+	record(REC_FILL_CIRCLE, xc-r, yc-r, 2*r+1, 2*r+1, color);
+}
+
+coord_t lcd_drawString(coord_t x, coord_t y, const char *ascii, color_t color)
+{
+	coord_t w = strlen(ascii) * LCD_CHAR_W;
+	record(REC_STRING, x, y, w, LCD_CHAR_H, color);
+	for (const char *c = ascii; *c; c++) hash(*c);
+	return x + w;
+}
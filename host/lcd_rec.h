@@ -0,0 +1,25 @@
+// Recording LCD backend for host builds of the game code (lcd_rec.c).
+// It takes the place of the LCD component: drawing calls are counted and
+// hashed, and nothing is drawn, so the game can be run and profiled
+// without the cost of the rasterizer. The hash of the calls changes if
+// anything about the drawing changes.
+
+#ifndef LCD_REC_H_
+#define LCD_REC_H_
+
+#include <stdint.h>
+
+// Drawing call counters
+typedef struct {
+	uint64_t calls;  // Drawing calls
+	uint64_t pixels; // Pixels covered (clipped to the screen)
+	uint32_t sum;    // Hash of the calls and their arguments
+} lcd_rec_stats_t;
+
+// Get the drawing call counters
+void lcd_rec_getStats(lcd_rec_stats_t *stats);
+
+// Reset the drawing call counters
+void lcd_rec_resetStats(void);
+
+#endif // LCD_REC_H_
@@ -0,0 +1,349 @@
+// Level pack tool for the host (Linux).
+// Reads levels from a text file (see levels/levels.txt for the format) and
+// writes a level pack (level.h), as a binary file for the asset partition
+// or as C source for the pack linked into the program. Each level is
+// stored in the smallest form: hit points only if a brick has more than
+// one, half rows if the level is symmetric, and run-length encoded if
+// that is smaller. The pack is then
+// opened with level_open() and each level decoded with level_load() and
+// compared with the text, so a pack that is written also loads.
+//
+// Usage: level_pack [-o file] [-c name] [-r levels] [file]
+//   -o file    Write the pack to a binary file.
+//   -c name    Write the pack to stdout as C source, an array named name.
+//   -r levels  Add generated levels (e.g. to check the size of a pack).
+//   file       Levels text file.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h> // atoi, strtol
+#include <string.h> // strchr, strncmp, memcmp
+#include <ctype.h> // isspace
+#include <unistd.h> // getopt
+
+#include "brick.h"
+#include "level.h"
+
+#define MAX_LEVELS 4096
+#define PACK_MAX 65536 // Offsets are 2 bytes
+#define LINE_MAX_LEN 512
+#define SEED 1
+
+// Level as read from the text file
+typedef struct {
+	uint8_t rows, cols;
+	uint8_t sx, sy, h;
+	uint8_t cell[MAX_BRICK_ROWS][MAX_BRICK_COLS];
+} level_t;
+
+static level_t levels[MAX_LEVELS];
+static int32_t nlevels;
+
+static uint8_t pack[PACK_MAX];
+static uint32_t pack_len;
+
+
+/************************ Text Input *************************/
+// Parse one cell token. Return false if bad.
+static bool parse_cell(const char *tok, uint8_t *cell)
+{
+	if (!strcmp(tok, ".")) {
+		*cell = 0;
+		return true;
+	}
+	const char *code = strchr(LEVEL_COLOR_CODES, tok[0]);
+	if (!tok[0] || !code) return false;
+	long hp = 1;
+	if (tok[1]) {
+		char *end;
+		hp = strtol(tok + 1, &end, 10);
+		if (*end || hp < 1 || hp > BRICK_HP_MAX) return false;
+	}
+	*cell = BRICK_CELL(code - LEVEL_COLOR_CODES + 1, hp);
+	return true;
+}
+
+static bool read_levels(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "can't read %s\n", path);
+		return false;
+	}
+	char line[LINE_MAX_LEN];
+	level_t *lv = NULL;
+	int32_t ln = 0;
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), f)) {
+		ln++;
+		char *s = line;
+		while (isspace((unsigned char)*s)) s++;
+		if (!*s || *s == '#') continue;
+
+		if (!strncmp(s, "level", 5)) {
+			int sx, sy, h;
+			if (nlevels == MAX_LEVELS ||
+				sscanf(s + 5, "%d %d %d", &sx, &sy, &h) != 3 ||
+				sx < 0 || sx > 255 || sy < 0 || sy > 255 || h < 1 || h > 255) {
+				ok = false;
+				break;
+			}
+			lv = &levels[nlevels++];
+			*lv = (level_t){0, 0, sx, sy, h, {{0}}};
+			continue;
+		}
+
+		// Row of cells
+		if (!lv || lv->rows == MAX_BRICK_ROWS) {
+			ok = false;
+			break;
+		}
+		int32_t c = 0;
+		for (char *tok = strtok(s, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
+			if (c == MAX_BRICK_COLS || !parse_cell(tok, &lv->cell[lv->rows][c])) {
+				ok = false;
+				break;
+			}
+			c++;
+		}
+		if (lv->rows && c != lv->cols) ok = false;
+		lv->cols = c;
+		lv->rows++;
+	}
+	fclose(f);
+	if (!ok) fprintf(stderr, "%s:%ld: bad level\n", path, (long)ln);
+	for (int32_t i = 0; ok && i < nlevels; i++) {
+		const level_t *lv = &levels[i];
+		if (!lv->rows) {
+			fprintf(stderr, "%s: level %ld has no rows\n", path, (long)i + 1);
+			ok = false;
+		} else if (!level_fits(lv->rows, lv->cols, lv->sx, lv->sy, lv->h)) {
+			fprintf(stderr, "%s: level %ld is off the screen\n", path, (long)i + 1);
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+// Add a generated level: symmetric rows of runs, some repeated, and
+// multi-hit bricks in one level out of four
+static uint32_t seed = SEED;
+static uint32_t gen_rand(uint32_t n)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) % n;
+}
+
+static void gen_level(level_t *lv)
+{
+	*lv = (level_t){4 + gen_rand(MAX_BRICK_ROWS - 3), 8 + gen_rand(MAX_BRICK_COLS - 7),
+		4, 4, 12, {{0}}};
+	bool tough = !gen_rand(4);
+	for (int32_t r = 0; r < lv->rows; r++) {
+		if (r && gen_rand(2)) { // Same as the row above
+			memcpy(lv->cell[r], lv->cell[r-1], lv->cols);
+			continue;
+		}
+		uint8_t cell = 0;
+		for (int32_t c = 0; c < (lv->cols + 1) / 2; c++) {
+			if (!c || !gen_rand(4)) {
+				uint32_t color = gen_rand(strlen(LEVEL_COLOR_CODES) + 1);
+				uint32_t hp = tough && !gen_rand(3) ? 2 : 1;
+				cell = color ? BRICK_CELL(color, hp) : 0;
+			}
+			lv->cell[r][c] = lv->cell[r][lv->cols - 1 - c] = cell;
+		}
+	}
+}
+
+/************************ Pack Output *************************/
+static bool put(const uint8_t *b, uint32_t n)
+{
+	if (pack_len + n > PACK_MAX) return false;
+	memcpy(pack + pack_len, b, n);
+	pack_len += n;
+	return true;
+}
+
+// Run-length encode n bytes. Return the encoded size.
+static uint32_t rle(const uint8_t *cells, uint32_t n, uint8_t *out)
+{
+	uint32_t len = 0, i = 0, lit = 0; // lit: cells pending as literals
+	while (i < n) {
+		uint32_t run = 1;
+		while (i + run < n && cells[i + run] == cells[i] && run < 128) run++;
+		if (run >= 3 || lit == 128) {
+			if (lit) { // Flush literals
+				out[len++] = lit - 1;
+				memcpy(out + len, cells + i - lit, lit);
+				len += lit;
+				lit = 0;
+			}
+			if (run >= 3) {
+				out[len++] = 0x80 | (run - 1);
+				out[len++] = cells[i];
+				i += run;
+				continue;
+			}
+		}
+		lit++;
+		i++;
+	}
+	if (lit) {
+		out[len++] = lit - 1;
+		memcpy(out + len, cells + n - lit, lit);
+		len += lit;
+	}
+	return len;
+}
+
+// Nibble stream of a level's cells. Return the flags and the stream
+// length in bytes.
+static uint8_t pack_cells(const level_t *lv, uint8_t *out, uint32_t *len)
+{
+	uint8_t flags = LEVEL_MIRROR;
+	for (int32_t r = 0; r < lv->rows; r++) {
+		for (int32_t c = 0; c < lv->cols; c++) {
+			uint8_t cell = lv->cell[r][c];
+			if (BRICK_CELL_HP(cell) > 1) flags |= LEVEL_HP;
+			if (cell != lv->cell[r][lv->cols - 1 - c]) flags &= ~LEVEL_MIRROR;
+		}
+	}
+	int32_t stored = flags & LEVEL_MIRROR ? (lv->cols + 1) / 2 : lv->cols;
+	uint32_t n = 0; // Nibbles
+	memset(out, 0, 2 * MAX_BRICK_ROWS * MAX_BRICK_COLS);
+	for (int32_t r = 0; r < lv->rows; r++) {
+		for (int32_t c = 0; c < stored; c++) {
+			uint8_t cell = lv->cell[r][c];
+			out[n/2] |= BRICK_CELL_COLOR(cell) << (n & 1) * 4;
+			n++;
+			if (flags & LEVEL_HP) {
+				out[n/2] |= BRICK_CELL_HP(cell) << (n & 1) * 4;
+				n++;
+			}
+		}
+	}
+	*len = (n + 1) / 2;
+	return flags;
+}
+
+static bool write_pack(uint32_t *rle_count)
+{
+	uint8_t hdr[LEVEL_HDR_SZ] = {'L', 'V', 'L', 'P', LEVEL_VERSION, 0,
+		nlevels & 0xFF, nlevels >> 8};
+	pack_len = 0;
+	*rle_count = 0;
+	put(hdr, sizeof(hdr));
+	pack_len += 2 * nlevels; // Offsets, filled in below
+	for (int32_t i = 0; i < nlevels; i++) {
+		const level_t *lv = &levels[i];
+		uint8_t cells[2 * MAX_BRICK_ROWS * MAX_BRICK_COLS];
+		uint8_t enc[4 * MAX_BRICK_ROWS * MAX_BRICK_COLS];
+		uint32_t n;
+		uint8_t flags = pack_cells(lv, cells, &n);
+		uint32_t elen = rle(cells, n, enc);
+		bool use_rle = elen < n;
+		if (use_rle) flags |= LEVEL_RLE;
+
+		if (pack_len >= PACK_MAX) return false;
+		pack[LEVEL_HDR_SZ + 2*i] = pack_len & 0xFF;
+		pack[LEVEL_HDR_SZ + 2*i + 1] = pack_len >> 8;
+		uint8_t rec[LEVEL_REC_SZ] = {lv->rows, lv->cols, flags,
+			lv->sx, lv->sy, lv->h};
+		if (!put(rec, sizeof(rec)) ||
+			!put(use_rle ? enc : cells, use_rle ? elen : n))
+			return false;
+		*rle_count += use_rle;
+	}
+	return true;
+}
+
+// Decode every level of the pack and compare it with the text
+static bool check_pack(void)
+{
+	level_pack_t lp;
+	if (level_open(&lp, pack, pack_len) || level_count(&lp) != (uint32_t)nlevels) {
+		fprintf(stderr, "pack doesn't open\n");
+		return false;
+	}
+	for (int32_t i = 0; i < nlevels; i++) {
+		const level_t *lv = &levels[i];
+		brick_grid_t grid;
+		bool ok = !level_load(&lp, i, &grid) && grid.rows == lv->rows &&
+			grid.cols == lv->cols && grid.spacing_x == lv->sx &&
+			grid.spacing_y == lv->sy && grid.brick_h == phys_from_int(lv->h);
+		uint32_t alive = 0;
+		for (int32_t r = 0; ok && r < lv->rows; r++) {
+			for (int32_t c = 0; c < lv->cols; c++) {
+				uint8_t cell = lv->cell[r][c];
+				if (!cell) {
+					ok = ok && !bricks_is_alive(&grid, r, c);
+					continue;
+				}
+				ok = ok && bricks_is_alive(&grid, r, c) && grid.cell[r][c] == cell;
+				alive++;
+			}
+		}
+		if (!ok || bricks_get_alive_count(&grid) != alive) {
+			fprintf(stderr, "level %ld doesn't decode\n", (long)i + 1);
+			return false;
+		}
+	}
+	return true;
+}
+
+static void print_c(const char *name)
+{
+	printf("// Generated by host/level_pack from levels/levels.txt, do not edit.\n");
+	printf("#include <stdint.h>\n\n");
+	printf("const uint8_t %s[] = {", name);
+	for (uint32_t i = 0; i < pack_len; i++)
+		printf("%s0x%02x,", i % 12 ? " " : "\n    ", pack[i]);
+	printf("\n};\n\nconst uint32_t %s_size = sizeof(%s);\n", name, name);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *opath = NULL, *cname = NULL;
+	int32_t gen = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "o:c:r:")) != -1) {
+		switch (opt) {
+		case 'o': opath = optarg; break;
+		case 'c': cname = optarg; break;
+		case 'r': gen = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-o file] [-c name] [-r levels] [file]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (optind < argc && !read_levels(argv[optind])) return 1;
+	for (int32_t i = 0; i < gen && nlevels < MAX_LEVELS; i++)
+		gen_level(&levels[nlevels++]);
+	if (!nlevels) {
+		fprintf(stderr, "no levels\n");
+		return 1;
+	}
+
+	uint32_t nrle;
+	if (!write_pack(&nrle)) {
+		fprintf(stderr, "pack larger than %d bytes\n", PACK_MAX);
+		return 1;
+	}
+	if (!check_pack()) return 1;
+	fprintf(stderr, "%ld levels (%lu run-length encoded), %lu bytes, %.1f bytes/level\n",
+		(long)nlevels, (unsigned long)nrle, (unsigned long)pack_len,
+		(double)pack_len / nlevels);
+
+	if (opath) {
+		FILE *f = fopen(opath, "wb");
+		if (!f || fwrite(pack, 1, pack_len, f) != pack_len || fclose(f)) {
+			fprintf(stderr, "can't write %s\n", opath);
+			return 1;
+		}
+	}
+	if (cname) print_c(cname);
+	return 0;
+}
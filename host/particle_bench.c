@@ -0,0 +1,186 @@
+// Particle benchmark on a host (Linux).
+// Keeps the particle pool full of brick-break bursts and reports the cost
+// per particle of a physics step (particles_tick) and of a frame
+// (render_begin and particles_draw), for several caps. Drawing is timed
+// both through the frame buffer, as on the device, and with a fill call
+// per particle when there is no frame buffer.
+//
+// The two ways of drawing must put the same pixels on the panel, the
+// number of live particles must never exceed the cap, and the dirty boxes
+// of a frame must cover every particle drawn. A mismatch fails.
+//
+// Usage: particle_bench [-r frames]
+//   -r frames  Frames timed for each cap and way of drawing (default 2000).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h> // atoi
+#include <time.h> // clock_gettime
+#include <unistd.h> // getopt
+
+#include "lcd.h"
+#include "lcd_host.h"
+#include "render.h"
+#include "particle.h"
+
+#define NS_SEC 1000000000LL
+#define FRAMES 2000
+#define FRAME_STEPS 8 // Physics steps per drawn frame
+#define BRICK_W 26    // Box of a burst, about a brick of the game
+#define BRICK_H 20
+#define BG BLACK
+
+static const uint32_t caps[] = {64, 256, 1024, CONFIG_MAX_PARTICLES};
+#define NUM_CAPS (sizeof(caps)/sizeof(caps[0]))
+
+static const color_t colors[] = {RED, WHITE, BLUE, GREEN, YELLOW, CYAN};
+#define NUM_COLORS (sizeof(colors)/sizeof(colors[0]))
+
+static particle_set_t set;
+static uint32_t seed = 1;
+static uint32_t fail;
+
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NS_SEC + ts.tv_nsec;
+}
+
+static uint32_t rnd(uint32_t n)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) % n;
+}
+
+// Burst boxes in the top half of the screen until the pool is full
+static void fill(void)
+{
+	while (set.count < set.cap) {
+		phys_t x = phys_from_int(rnd(LCD_W - BRICK_W));
+		phys_t y = phys_from_int(rnd(LCD_H/2 - BRICK_H));
+		particles_burst(&set, x, y, phys_from_int(BRICK_W), phys_from_int(BRICK_H),
+			colors[rnd(NUM_COLORS)], PARTICLE_BURST);
+	}
+}
+
+// The dirty boxes of the frame cover every particle on the screen
+static void check_dirty(void)
+{
+	render_box_t box[RENDER_MAX_DIRTY];
+	uint32_t n = render_dirty(box);
+	for (int32_t i = 0; i < set.count; i++) {
+		coord_t x = phys_floor(set.x[i]), y = phys_floor(set.y[i]);
+		if (x < 0 || y < 0 || x > LCD_W - PARTICLE_SIZE || y > LCD_H - PARTICLE_SIZE)
+			continue;
+		uint32_t b;
+		for (b = 0; b < n; b++)
+			if (x >= box[b].x && y >= box[b].y && x + PARTICLE_SIZE <= box[b].x + box[b].w &&
+					y + PARTICLE_SIZE <= box[b].y + box[b].h)
+				break;
+		if (b == n) {
+			if (!fail++)
+				fprintf(stderr, "particle at (%d,%d) outside the dirty boxes\n",
+					(int)x, (int)y);
+			return;
+		}
+	}
+}
+
+// Draw the same particles with and without the frame buffer
+static void check_paths(void)
+{
+	particles_init(&set);
+	fill();
+	for (int32_t s = 0; s < 4*FRAME_STEPS; s++)
+		particles_tick(&set, PHYS(CONFIG_PHYSICS_STEP));
+
+	lcd_frameEnable();
+	lcd_fillScreen(BG);
+	particles_draw(&set);
+	lcd_writeFrame();
+	uint32_t fast = lcd_host_checksum();
+
+	lcd_frameDisable();
+	lcd_fillScreen(BG);
+	particles_draw(&set);
+	uint32_t slow = lcd_host_checksum();
+	if (fast != slow) {
+		fprintf(stderr, "frame buffer 0x%08lx, fill calls 0x%08lx\n",
+			(unsigned long)fast, (unsigned long)slow);
+		fail++;
+	}
+}
+
+// Run frames at a cap. Return the particles stepped and drawn in *steps
+// and *drawn, and the time taken in *tick_ns and *draw_ns.
+static void run(uint32_t cap, int32_t frames, uint64_t *steps, uint64_t *drawn,
+	int64_t *tick_ns, int64_t *draw_ns)
+{
+	particles_init(&set);
+	particles_set_cap(&set, cap);
+	render_init(BG);
+	*steps = *drawn = 0;
+	*tick_ns = *draw_ns = 0;
+	for (int32_t f = 0; f < frames; f++) {
+		fill();
+		int64_t t = now_ns();
+		for (int32_t s = 0; s < FRAME_STEPS; s++) {
+			*steps += set.count;
+			particles_tick(&set, PHYS(CONFIG_PHYSICS_STEP));
+		}
+		int64_t t1 = now_ns();
+		render_begin();
+		particles_draw(&set);
+		int64_t t2 = now_ns();
+		*tick_ns += t1 - t;
+		*draw_ns += t2 - t1;
+		*drawn += set.count;
+		if (set.count > cap && !fail++)
+			fprintf(stderr, "%lu particles over the cap of %lu\n",
+				(unsigned long)set.count, (unsigned long)cap);
+		check_dirty();
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t frames = FRAMES;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:")) != -1) {
+		switch (opt) {
+		case 'r': frames = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-r frames]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (frames < 1) frames = 1;
+
+	lcd_init();
+	check_paths();
+
+	printf("particle_set_t: %zu bytes (max %d)\n",
+		sizeof(particle_set_t), CONFIG_MAX_PARTICLES);
+	printf("%-8s %-6s %10s %12s %12s\n",
+		"cap", "draw", "live", "tick ns/p", "frame ns/p");
+	for (int32_t fb = 1; fb >= 0; fb--) {
+		if (fb) lcd_frameEnable();
+		else lcd_frameDisable();
+		for (size_t i = 0; i < NUM_CAPS; i++) {
+			uint64_t steps, drawn;
+			int64_t tick_ns, draw_ns;
+			run(caps[i], frames, &steps, &drawn, &tick_ns, &draw_ns);
+			printf("%-8lu %-6s %10.1f %12.2f %12.2f\n",
+				(unsigned long)caps[i], fb ? "frame" : "fill",
+				(double)drawn / frames,
+				steps ? (double)tick_ns / steps : 0.0,
+				drawn ? (double)draw_ns / drawn : 0.0);
+		}
+	}
+	if (fail) fprintf(stderr, "%lu failed checks\n", (unsigned long)fail);
+	return fail != 0;
+}
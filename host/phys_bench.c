@@ -0,0 +1,283 @@
+// Game physics benchmark on a host (Linux).
+// Plays the game headless for a number of physics steps, with the A
+// button held and the joystick steering the platform under the ball, and
+// reports the time per game_tick. It is built twice, with fixed-point
+// physics (default) and with float physics (CONFIG_PHYSICS_FLOAT).
+//
+// A checksum of the game state after every step is compared with a
+// reference. Fixed-point results don't depend on the compiler or FPU, so
+// the same checksum is expected on every platform, the ESP32 included.
+//
+// With -b, extra balls are kept in play (stress mode) and the time to
+// draw a frame into the frame buffer is reported as well.
+//
+// The input of the checked run is recorded (see input.h) and replayed to
+// check that it gives the same checksum. The timed runs replay the log,
+// so they see exactly the same steps. With -p, a log recorded on the
+// device or with -w is replayed instead of steering.
+//
+// Usage: phys_bench [-s steps] [-b balls] [-w log] [-p log] [-u] [-n]
+//   -s steps  Physics steps to run (default 200000).
+//   -b balls  Extra balls in play (default 0).
+//   -w log    Write the recorded input log to a file.
+//   -p log    Replay an input log from a file, until it ends.
+//   -u        Print the checksum for updating the reference.
+//   -n        Don't compare with the reference (float physics).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h> // atoi, malloc
+#include <time.h> // clock_gettime
+#include <unistd.h> // getopt
+
+#include "hw.h"
+#include "lcd.h"
+#include "render.h"
+#include "pin.h"
+#include "joy.h"
+#include "input.h"
+#include "phys.h"
+#include "game.h"
+#include "config.h"
+
+#define NS_SEC 1000000000LL
+#define STEPS 200000
+#define FRAME_STEPS 8 // Physics steps per drawn frame
+#define LOG_STEP_MAX 6 // Most log bytes recorded per step
+
+#define FNV_INIT 0x811C9DC5u
+#define FNV_PRIME 0x01000193u
+
+// Reference checksum of the fixed-point run with the default steps
+#define REF_SUM 0x1ce161dfu
+
+extern ball_t game_ball;
+extern platform_t game_platform;
+
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NS_SEC + ts.tv_nsec;
+}
+
+/************************ Input Stubs *************************/
+// The A button is held (active low), so a new ball launches at once.
+int32_t pin_get_level(pin_num_t pin)
+{
+	return pin != HW_BTN_A;
+}
+
+// Steer the platform center under the ball (integer pixels, so both
+// builds see the same input while their positions agree).
+void joy_get_displacement(int32_t *dcx, int32_t *dcy)
+{
+	int32_t px = phys_floor(game_platform.x + game_platform.width/2);
+	int32_t d = (phys_floor(game_ball.x) - px) * (JOY_MAX_DISP/16);
+	if (d > JOY_MAX_DISP) d = JOY_MAX_DISP;
+	if (d < -JOY_MAX_DISP) d = -JOY_MAX_DISP;
+	*dcx = d;
+	*dcy = 0;
+}
+
+/************************ Checksum *************************/
+static uint32_t fnv(uint32_t h, const void *p, size_t n)
+{
+	const uint8_t *b = p;
+	while (n--) h = (h ^ *b++) * FNV_PRIME;
+	return h;
+}
+
+static uint32_t state_sum(uint32_t h)
+{
+	static game_state_t f;
+	game_save(&f);
+	h = fnv(h, &f.ball.x, sizeof(f.ball.x));
+	h = fnv(h, &f.ball.y, sizeof(f.ball.y));
+	h = fnv(h, &f.ball.dx, sizeof(f.ball.dx));
+	h = fnv(h, &f.ball.dy, sizeof(f.ball.dy));
+	h = fnv(h, &f.platform.x, sizeof(f.platform.x));
+	for (int32_t i = balls_first(&f.balls); i >= 0; i = balls_next(&f.balls, i)) {
+		h = fnv(h, &f.balls.x[i], sizeof(f.balls.x[i]));
+		h = fnv(h, &f.balls.y[i], sizeof(f.balls.y[i]));
+	}
+	h = fnv(h, f.bricks.alive, sizeof(f.bricks.alive));
+	return h;
+}
+
+/************************ Input Logs *************************/
+// Read a whole file. Return the buffer (free with free()), or NULL.
+static uint8_t *read_log(const char *path, uint32_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f) return NULL;
+	fseek(f, 0, SEEK_END);
+	long n = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	uint8_t *buf = n > 0 ? malloc(n) : NULL;
+	if (buf && fread(buf, 1, n, f) != (size_t)n) {
+		free(buf);
+		buf = NULL;
+	}
+	fclose(f);
+	*len = n;
+	return buf;
+}
+
+static bool write_log(const char *path, const uint8_t *log, uint32_t len)
+{
+	FILE *f = fopen(path, "wb");
+	if (!f) return false;
+	bool ok = fwrite(log, 1, len, f) == len;
+	return !fclose(f) && ok;
+}
+
+// Start a game, with input from log if not NULL or recorded otherwise.
+static void start(int32_t balls, const uint8_t *log, uint32_t len,
+	uint8_t *rec, uint32_t size)
+{
+	game_restart();
+	game_stress(balls);
+	if (log) input_replay(log, len);
+	else input_record(rec, size);
+}
+
+// Run up to steps physics steps, or until a replayed log ends.
+// Return the number of steps run. The state checksum is updated if sum
+// is not NULL.
+static int32_t run(int32_t steps, uint32_t *sum)
+{
+	const phys_t dt = PHYS(CONFIG_PHYSICS_STEP);
+	int32_t i;
+	for (i = 0; i < steps; i++) {
+		input_tick();
+		if (input_replay_done()) break;
+		game_tick(dt);
+		if (sum) *sum = state_sum(*sum);
+	}
+	return i;
+}
+
+int main(int argc, char *argv[])
+{
+	int32_t steps = STEPS;
+	int32_t balls = 0;
+	bool update = false;
+	bool nocmp = false;
+	const char *wpath = NULL, *ppath = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:b:w:p:un")) != -1) {
+		switch (opt) {
+		case 's': steps = atoi(optarg); break;
+		case 'b': balls = atoi(optarg); break;
+		case 'w': wpath = optarg; break;
+		case 'p': ppath = optarg; break;
+		case 'u': update = true; break;
+		case 'n': nocmp = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-s steps] [-b balls] [-w log] [-p log] [-u] [-n]\n",
+				argv[0]);
+			return 2;
+		}
+	}
+	if (steps < 1) steps = 1;
+	if (balls < 0) balls = 0;
+	if (balls > CONFIG_MAX_BALLS) balls = CONFIG_MAX_BALLS;
+
+	// Input log, replayed from a file or recorded in the checked run
+	uint8_t *log;
+	uint32_t len = 0;
+	if (ppath) {
+		log = read_log(ppath, &len);
+		if (!log) {
+			fprintf(stderr, "can't read %s\n", ppath);
+			return 2;
+		}
+		steps = INT32_MAX;
+	} else {
+		len = (uint32_t)steps * LOG_STEP_MAX;
+		log = malloc(len);
+		if (!log) return 2;
+	}
+
+	// Checked run
+	start(balls, ppath ? log : NULL, len, log, len);
+	uint32_t sum = FNV_INIT;
+	steps = run(steps, &sum);
+	if (!steps) {
+		fprintf(stderr, "empty input log\n");
+		return 2;
+	}
+	game_frame_t f;
+	game_snapshot(&f);
+	uint32_t left = bricks_get_alive_count(&f.bricks);
+
+	// Replay the recorded input, the checksum must be the same
+	if (!ppath) {
+		len = input_record_len();
+		if (wpath && !write_log(wpath, log, len)) {
+			fprintf(stderr, "can't write %s\n", wpath);
+			return 2;
+		}
+		uint32_t rsum = FNV_INIT;
+		start(balls, log, len, NULL, 0);
+		run(steps, &rsum);
+		if (rsum != sum) {
+			fprintf(stderr, "replay checksum 0x%08lx, recorded 0x%08lx\n",
+				(unsigned long)rsum, (unsigned long)sum);
+			return 1;
+		}
+	}
+
+	// Timed run, replaying the input
+	start(balls, log, len, NULL, 0);
+	int64_t t0 = now_ns();
+	run(steps, NULL);
+	int64_t diff = now_ns() - t0;
+
+	// Timed drawing, one frame every FRAME_STEPS steps
+	int64_t draw = 0;
+	int32_t frames = 0;
+	if (balls) {
+		lcd_init();
+		lcd_frameEnable();
+		render_init(CONFIG_COLOR_BACKGROUND);
+		start(balls, log, len, NULL, 0);
+		static game_frame_t frame;
+		for (int32_t i = 0; i < steps; i++) {
+			run(1, NULL);
+			if (i % FRAME_STEPS) continue;
+			game_snapshot(&frame);
+			int64_t t = now_ns();
+			render_begin();
+			game_draw(&frame);
+			draw += now_ns() - t;
+			frames++;
+		}
+	}
+
+#ifdef CONFIG_PHYSICS_FLOAT
+	const char *kind = "float";
+#else
+	const char *kind = "Q16.16";
+#endif
+	printf("%s physics: %ld steps, %.1f ns/tick, %lu bricks left, checksum 0x%08lx\n",
+		kind, (long)steps, (double)diff/steps, (unsigned long)left,
+		(unsigned long)sum);
+	printf("input log: %lu bytes, %.2f bytes/step\n",
+		(unsigned long)len, (double)len/steps);
+	if (balls)
+		printf("%ld extra balls: %.1f ns/ball/tick, %.1f us/frame drawn\n",
+			(long)balls, (double)diff/steps/(balls+1), draw/1000.0/frames);
+	if (update) printf("#define REF_SUM 0x%08lxu\n", (unsigned long)sum);
+	free(log);
+	if (!nocmp && !ppath && steps == STEPS && !balls && sum != REF_SUM) {
+		fprintf(stderr, "checksum 0x%08lx, expected 0x%08lx\n",
+			(unsigned long)sum, (unsigned long)REF_SUM);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,57 @@
+// Null sound driver for host builds of the game code, see sound_null.h.
+
+#include "sound.h"
+#include "sound_null.h"
+
+static uint32_t starts;
+
+uint32_t sound_null_getStarts(void)
+{
+	return starts;
+}
+
+void sound_null_resetStarts(void)
+{
+	starts = 0;
+}
+
+int32_t sound_init(uint32_t sample_hz)
+{
+	(void)sample_hz;
+	return 0;
+}
+
+int32_t sound_deinit(void)
+{
+	return 0;
+}
+
+void sound_start(const void *audio, uint32_t size, bool wait)
+{
+	(void)audio; (void)size; (void)wait;
+	starts++;
+}
+
+void sound_cyclic(const void *audio, uint32_t size)
+{
+	(void)audio; (void)size;
+}
+
+bool sound_busy(void)
+{
+	return false;
+}
+
+void sound_stop(void)
+{
+}
+
+void sound_set_volume(uint32_t vol)
+{
+	(void)vol;
+}
+
+void sound_device(bool enable)
+{
+	(void)enable;
+}
@@ -0,0 +1,15 @@
+// Null sound driver for host builds of the game code (sound_null.c).
+// Sounds are accepted and dropped, and counted.
+
+#ifndef SOUND_NULL_H_
+#define SOUND_NULL_H_
+
+#include <stdint.h>
+
+// Get the number of sounds started since the last reset
+uint32_t sound_null_getStarts(void);
+
+// Reset the count of sounds started
+void sound_null_resetStarts(void);
+
+#endif // SOUND_NULL_H_
@@ -0,0 +1,225 @@
+% Clear command window & workspace, and close all figures
+clc, clear, close all;
+
+o_max_w = 320; % output image maximum width
+o_max_h = 240; % output image maximum height
+o_file = "assets.bin"; % output asset blob
+o_rle = true; % store images as RLE when it is smaller than raw rgb565
+name_len = 16; % maximum name length including terminator (ASSET_NAME_LEN)
+
+% Asset formats (asset_fmt_t in components/asset/asset.h)
+FMT_RAW = 0;
+FMT_RGB565 = 1;
+FMT_RLE565 = 2;
+
+% Select image files to pack. Binary files (*.bin, e.g. level packs or
+% input logs) are packed as raw data.
+[fname,location] = uigetfile(...
+    '*.bmp;*.cur;*.gif;*.hdf4;*.ico;*.jpg;*.jpeg;*.pcx;*.pbm;*.pgm;*.png;*.ppm;*.ras;*.tif;*.tiff;*.xwd;*.bin',...
+    'Select one or more image or binary files',...
+    'MultiSelect','on');
+if isequal(fname,0) % user canceled selection
+    disp('No file(s) selected');
+    return;
+elseif ischar(fname) % convert to cell array if single file selected
+    fname = {fname};
+end
+
+% Process image data into a list of assets
+assets = struct('name',{},'data',{},'w',{},'h',{},'fmt',{});
+for i = 1:length(fname)
+    [~,name,ext] = fileparts(fname{i}); % asset name is file name
+    if strlength(name) > name_len-1
+        fprintf(' -- error: %s name longer than %u.\n', fname{i}, name_len-1);
+        continue
+    end
+
+    % raw data file
+    if strcmpi(ext,'.bin')
+        fid = fopen(fullfile(location,fname{i}), 'r');
+        a.name = char(name);
+        a.data = uint8(fread(fid, Inf, 'uint8'));
+        a.w = 0;
+        a.h = 0;
+        a.fmt = FMT_RAW;
+        fclose(fid);
+        fprintf('Packed: %s, raw, %u bytes\n', a.name, length(a.data));
+        assets(end+1) = a; %#ok<SAGROW>
+        continue
+    end
+
+    % read image file into a matrix
+    % returns: [image data, colormap values]
+    [x,cmap] = imread(fullfile(location,fname{i}));
+
+    % if indexed (colormapped) image, convert to 24-bit RGB
+    if numel(cmap) > 0
+        fprintf('Converting: %s to 24-bit RGB.\n', fname{i});
+        x = uint8(ind2rgb(x,cmap) .* 255);
+    end
+
+    % skip if not in 24-bit RGB format
+    if size(x,3) ~= 3 || ~isa(x,'uint8')
+        fprintf(' -- error: %s not in 24-bit RGB format.\n', fname{i});
+        continue
+    end
+
+    % resize image if a dimension is greater than maximum width or height
+    if size(x,2) > o_max_w || size(x,1) > o_max_h
+        fprintf('Resizing: %s\n', fname{i});
+        if size(x,2)/o_max_w > size(x,1)/o_max_h
+            xs = imresize(x,[NaN,o_max_w]);
+        else
+            xs = imresize(x,[o_max_h,NaN]);
+        end
+    else
+        xs = x;
+    end
+
+    % convert to rgb565
+    xr =          bitshift(uint16(bitand(xs(:,:,1),0xF8)), 8); % left by 8
+    xr = bitor(xr,bitshift(uint16(bitand(xs(:,:,2),0xFC)), 3)); % left by 3
+    xr = bitor(xr,bitshift(uint16(bitand(xs(:,:,3),0xF8)),-3)); % right by 3
+
+    % flatten matrix (row-wise) to a vector
+    xr = reshape(xr.',[],1);
+
+    a.name = char(name);
+    a.w = size(xs,2);
+    a.h = size(xs,1);
+    a.data = xr;
+    a.fmt = FMT_RGB565;
+    if o_rle
+        xe = rle565(xr);
+        if length(xe) < length(xr)
+            a.data = xe;
+            a.fmt = FMT_RLE565;
+        end
+    end
+    a.data = typecast(a.data, 'uint8'); % little endian words
+    fprintf('Packed: %s, %ux%u, %u bytes\n', a.name, a.w, a.h, length(a.data));
+    assets(end+1) = a; %#ok<SAGROW>
+end
+pack_assets(assets, o_file, name_len);
+
+% Write the asset blob read by components/asset/asset.c.
+%   assets: struct array with name, data (uint8), w, h and fmt fields
+%   file: output file name
+%   name_len: size of the name field in each index entry
+function pack_assets(assets, file, name_len)
+    HDR_SZ = 16; % sizeof(asset_hdr_t)
+    ENT_SZ = 20 + name_len; % sizeof(asset_ent_t)
+    n = length(assets);
+    slots = 2 ^ nextpow2(max(2*n,1)); % keep load factor at or below 1/2
+
+    % place each asset in the index by hash, probing linearly on collision
+    hash = zeros(slots,1,'uint32');
+    slot_of = zeros(n,1);
+    for i = 1:n
+        h = fnv1a(assets(i).name);
+        s = bitand(h, uint32(slots-1));
+        while hash(s+1) ~= 0
+            s = mod(s+1, slots);
+        end
+        hash(s+1) = h;
+        slot_of(i) = s;
+    end
+
+    % assign data offsets, each aligned to 4 bytes
+    offset = zeros(n,1);
+    pos = HDR_SZ + slots*ENT_SZ;
+    for i = 1:n
+        pos = ceil(pos/4)*4;
+        offset(i) = pos;
+        pos = pos + length(assets(i).data);
+    end
+
+    fid = fopen(file, 'w', 'l');
+    % header
+    fwrite(fid, uint8('ASET'), 'uint8');
+    fwrite(fid, [1 n slots 0], 'uint16');
+    fwrite(fid, pos, 'uint32');
+    % index
+    for s = 0:slots-1
+        i = find(slot_of == s & hash(s+1) ~= 0, 1);
+        if isempty(i)
+            fwrite(fid, zeros(ENT_SZ,1), 'uint8');
+            continue
+        end
+        a = assets(i);
+        fwrite(fid, [hash(s+1) offset(i) length(a.data)], 'uint32');
+        fwrite(fid, [a.w a.h], 'uint16');
+        fwrite(fid, [a.fmt 0 0 0], 'uint8');
+        name = zeros(1,name_len,'uint8');
+        name(1:length(a.name)) = uint8(a.name);
+        fwrite(fid, name, 'uint8');
+    end
+    % data
+    for i = 1:n
+        fwrite(fid, zeros(offset(i)-ftell(fid),1), 'uint8'); % align
+        fwrite(fid, assets(i).data, 'uint8');
+    end
+    fclose(fid);
+    fprintf('Wrote: %s, %u assets, %u bytes\n', file, n, pos);
+end
+
+% FNV-1a hash of a name. Must match asset_hash() in components/asset/asset.c.
+function h = fnv1a(name)
+    h = uint64(2166136261);
+    for c = uint8(name)
+        h = bitxor(h, uint64(c));
+        h = mod(h * uint64(16777619), uint64(2^32));
+    end
+    h = uint32(h);
+    if h == 0; h = uint32(1); end
+end
+
+% Run-length encode a vector of rgb565 pixels for lcd_drawImageRLE().
+% Same encoding as image2c_rle.m.
+%   x: vector of rgb565 pixel values
+%   Returns a vector of encoded 16-bit words
+function e = rle565(x)
+    MIN_RUN = 3; % shortest repeat stored as a run
+    MAX_CNT = 32767; % largest count in a header
+    n = length(x);
+    e = zeros(n*2,1,'uint16'); % worst case, trimmed at end
+    pos = 0; % words written
+    lit = 0; % start index of pending literals (0 if none)
+    i = 1;
+    while i <= n
+        % measure the run starting at i
+        j = i;
+        while j < n && x(j+1) == x(i) && j-i+1 < MAX_CNT
+            j = j+1;
+        end
+        run = j-i+1;
+        if run >= MIN_RUN
+            if lit > 0 % flush pending literals
+                [e,pos] = emit_lit(e,pos,x(lit:i-1));
+                lit = 0;
+            end
+            e(pos+1) = bitor(uint16(0x8000),uint16(run));
+            e(pos+2) = x(i);
+            pos = pos+2;
+            i = j+1;
+        else
+            if lit == 0; lit = i; end
+            if i-lit+1 == MAX_CNT % literal packet is full
+                [e,pos] = emit_lit(e,pos,x(lit:i));
+                lit = 0;
+            end
+            i = i+1;
+        end
+    end
+    if lit > 0
+        [e,pos] = emit_lit(e,pos,x(lit:n));
+    end
+    e = e(1:pos);
+end
+
+% Append a literal packet (header word and colors) to the encoded vector.
+function [e,pos] = emit_lit(e,pos,v)
+    e(pos+1) = uint16(length(v));
+    e(pos+2:pos+1+length(v)) = v;
+    pos = pos+1+length(v);
+end
@@ -0,0 +1,175 @@
+% Clear command window & workspace, and close all figures
+clc, clear, close all;
+
+o_max_w = 320; % output image maximum width
+o_max_h = 240; % output image maximum height
+o_bits = 16; % output image bits per pixel
+o_dir = "rle565"; % output sub-directory
+
+% Select image files to convert
+[fname,location] = uigetfile(...
+    '*.bmp;*.cur;*.gif;*.hdf4;*.ico;*.jpg;*.jpeg;*.pcx;*.pbm;*.pgm;*.png;*.ppm;*.ras;*.tif;*.tiff;*.xwd',...
+    'Select one or more image files',...
+    'MultiSelect','on');
+if isequal(fname,0) % user canceled selection
+    disp('No file(s) selected');
+    return;
+elseif ischar(fname) % convert to cell array if single file selected
+    fname = {fname};
+end
+
+% Create output sub-directory if nonexistent
+if not(isfolder(o_dir))
+    mkdir(o_dir);
+end
+
+% Process image data
+for i = 1:length(fname)
+    % read image file into a matrix
+    % returns: [image data, colormap values]
+    [x,cmap] = imread(fullfile(location,fname{i}));
+
+    % if indexed (colormapped) image, convert to 24-bit RGB
+    if numel(cmap) > 0
+        fprintf('Converting: %s to 24-bit RGB.\n', fname{i});
+        x = uint8(ind2rgb(x,cmap) .* 255);
+    end
+
+    % skip if not in 24-bit RGB format
+    if size(x,3) ~= 3 || ~isa(x,'uint8')
+        fprintf(' -- error: %s not in 24-bit RGB format.\n', fname{i});
+        continue
+    end
+
+    % resize image if a dimension is greater than maximum width or height
+    if size(x,2) > o_max_w || size(x,1) > o_max_h
+        fprintf('Resizing: %s\n', fname{i});
+        if size(x,2)/o_max_w > size(x,1)/o_max_h
+            xs = imresize(x,[NaN,o_max_w]);
+        else
+            xs = imresize(x,[o_max_h,NaN]);
+        end
+    else
+        xs = x;
+    end
+
+    % show the resized image
+    figure, imshow(xs);
+
+    % convert to rgb565
+    xr =          bitshift(uint16(bitand(xs(:,:,1),0xF8)), 8); % left by 8
+    xr = bitor(xr,bitshift(uint16(bitand(xs(:,:,2),0xFC)), 3)); % left by 3
+    xr = bitor(xr,bitshift(uint16(bitand(xs(:,:,3),0xF8)),-3)); % right by 3
+
+    % flatten matrix (row-wise) to a vector
+    xr = reshape(xr.',[],1);
+
+    % run-length encode the pixels
+    xe = rle565(xr);
+    fprintf('Encoded: %s, %u to %u words (%.1fx)\n', fname{i}, ...
+        length(xr), length(xe), length(xr)/length(xe));
+
+    % save data to file in a 'C' array
+    [path,name,ext] = fileparts(fname{i}); % split filename
+    path = fullfile(path,o_dir); % output to sub-directory
+    dat2c_rle(xe,path,name,size(xs,2),size(xs,1),o_bits);
+end
+
+% Run-length encode a vector of rgb565 pixels for lcd_drawImageRLE().
+% Each packet starts with a header word. If bit 15 (0x8000) is set, the
+% next word is a color repeated (header & 0x7FFF) times (a run). Otherwise,
+% (header & 0x7FFF) literal colors follow. Runs shorter than MIN_RUN are
+% folded into literal packets since they would not save any space.
+%   x: vector of rgb565 pixel values
+%   Returns a vector of encoded 16-bit words
+function e = rle565(x)
+    MIN_RUN = 3; % shortest repeat stored as a run
+    MAX_CNT = 32767; % largest count in a header
+    n = length(x);
+    e = zeros(n*2,1,'uint16'); % worst case, trimmed at end
+    pos = 0; % words written
+    lit = 0; % start index of pending literals (0 if none)
+    i = 1;
+    while i <= n
+        % measure the run starting at i
+        j = i;
+        while j < n && x(j+1) == x(i) && j-i+1 < MAX_CNT
+            j = j+1;
+        end
+        run = j-i+1;
+        if run >= MIN_RUN
+            if lit > 0 % flush pending literals
+                [e,pos] = emit_lit(e,pos,x(lit:i-1));
+                lit = 0;
+            end
+            e(pos+1) = bitor(uint16(0x8000),uint16(run));
+            e(pos+2) = x(i);
+            pos = pos+2;
+            i = j+1;
+        else
+            if lit == 0; lit = i; end
+            if i-lit+1 == MAX_CNT % literal packet is full
+                [e,pos] = emit_lit(e,pos,x(lit:i));
+                lit = 0;
+            end
+            i = i+1;
+        end
+    end
+    if lit > 0
+        [e,pos] = emit_lit(e,pos,x(lit:n));
+    end
+    e = e(1:pos);
+end
+
+% Append a literal packet (header word and colors) to the encoded vector.
+function [e,pos] = emit_lit(e,pos,v)
+    e(pos+1) = uint16(length(v));
+    e(pos+2:pos+1+length(v)) = v;
+    pos = pos+1+length(v);
+end
+
+% Given a MATLAB array of RLE words, create a 'C' array in text.
+%   x: MATLAB array of RLE words
+%   path: directory path to create 'C' file
+%   name: name of 'C' array and also files with .h and .c extension
+%   w: output image width
+%   h: output image height
+%   bits: output image bits per pixel
+%   Returns the length of the MATLAB array
+function l = dat2c_rle(x,path,name,w,h,bits)
+    str = upper(name);
+    t_type = "uint16_t"; % target array element type
+
+    %%%%%%%%%%%%%%%%%%%% Write .h File %%%%%%%%%%%%%%%%%%%%
+    fid_h = fopen(fullfile(path,name+".h"), 'w');
+    fprintf(fid_h, "\n#include <stdint.h>\n\n");
+    fprintf(fid_h, "#define %s_BITS_PER_PIXEL %u\n", str, bits);
+    fprintf(fid_h, "#define %s_LENGTH %u\n", str, length(x));
+    fprintf(fid_h, "#define %s_W %u\n", str, w);
+    fprintf(fid_h, "#define %s_H %u\n\n", str, h);
+    fprintf(fid_h, "extern const %s %s[%s_LENGTH];\n", t_type, name, str);
+    fclose(fid_h);
+
+    %%%%%%%%%%%%%%%%%%%% Write .c File %%%%%%%%%%%%%%%%%%%%
+    ELEM_LINE = 16; % 'C' array elements per line
+    t_format = sprintf(" 0x%%0%ux,", 4);
+    fid_c = fopen(fullfile(path,name+".c"), 'w');
+    pos = 0;
+    elem = length(x);
+
+    fprintf(fid_c, "\n#include <stdint.h>\n\n");
+    fprintf(fid_c, "const %s %s[] = {\n", t_type, name); % start array
+    while elem > 0 % array data
+        if elem < ELEM_LINE; size = elem; else; size = ELEM_LINE; end
+        for i = 1:size
+            fprintf(fid_c, t_format, x(pos+i));
+        end
+        pos = pos+size;
+        elem = elem-size;
+        fprintf(fid_c, "\n");
+    end
+    fprintf(fid_c, "};\n"); % end array
+    fclose(fid_c);
+
+    l = length(x);
+end
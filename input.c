@@ -0,0 +1,216 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hw.h"
+#include "pin.h"
+#include "joy.h"
+#include "input.h"
+
+#define RUN_MAX 128 // Longest run of one record
+
+// Input sources
+enum input_mode_t {
+    live_md,
+    record_md,
+    replay_md
+};
+
+static uint8_t mode;
+static input_bot_t bot;
+static input_t cur;  // Input for this step
+static input_t prev; // Input of the last step (recorded or replayed)
+
+// Recording
+static uint8_t *rec_buf;
+static uint32_t rec_size, rec_len;
+static uint32_t rec_run; // Steps repeating prev not yet written
+
+// Replay
+static const uint8_t *rep_log;
+static uint32_t rep_len, rep_pos;
+static uint32_t rep_run; // Steps left repeating the current input
+static bool rep_done;
+
+static const input_t idle = {0, 0, 0};
+
+/************************ Live Input *************************/
+static void sample(input_t *in) {
+    int32_t x, y;
+    in->buttons = 0;
+    if (!pin_get_level(HW_BTN_A))      in->buttons |= INPUT_A;
+    if (!pin_get_level(HW_BTN_B))      in->buttons |= INPUT_B;
+    if (!pin_get_level(HW_BTN_START))  in->buttons |= INPUT_START;
+    if (!pin_get_level(HW_BTN_SELECT)) in->buttons |= INPUT_SELECT;
+    if (!pin_get_level(HW_BTN_OPTION)) in->buttons |= INPUT_OPTION;
+    joy_get_displacement(&x, &y);
+    in->joy_x = x;
+    in->joy_y = y;
+}
+
+/************************ Recording *************************/
+// Append bytes to the log. Return false if the log is full.
+static bool put(const uint8_t *b, uint32_t n) {
+    if (rec_len + n > rec_size) {
+        mode = live_md; // Full, stop recording
+        return false;
+    }
+    for (uint32_t i = 0; i < n; i++) rec_buf[rec_len++] = b[i];
+    return true;
+}
+
+static void flush_run(void) {
+    if (!rec_run) return;
+    uint8_t r = rec_run - 1;
+    if (put(&r, 1)) rec_run = 0;
+}
+
+static void record(const input_t *in) {
+    if (in->buttons == prev.buttons && in->joy_x == prev.joy_x &&
+        in->joy_y == prev.joy_y) {
+        if (++rec_run == RUN_MAX) flush_run();
+        return;
+    }
+    flush_run();
+
+    uint8_t rec[6], n = 1;
+    uint8_t f = 0x80;
+    int32_t dx = in->joy_x - prev.joy_x;
+    int32_t dy = in->joy_y - prev.joy_y;
+    if (in->buttons != prev.buttons) {
+        f |= INPUT_F_BTN;
+        rec[n++] = in->buttons;
+    }
+    if (dx >= -128 && dx <= 127) {
+        if (dx) {
+            f |= INPUT_F_XS;
+            rec[n++] = (uint8_t)dx;
+        }
+    } else {
+        f |= INPUT_F_XL;
+        rec[n++] = (uint16_t)in->joy_x;
+        rec[n++] = (uint16_t)in->joy_x >> 8;
+    }
+    if (dy >= -128 && dy <= 127) {
+        if (dy) {
+            f |= INPUT_F_YS;
+            rec[n++] = (uint8_t)dy;
+        }
+    } else {
+        f |= INPUT_F_YL;
+        rec[n++] = (uint16_t)in->joy_y;
+        rec[n++] = (uint16_t)in->joy_y >> 8;
+    }
+    rec[0] = f;
+    put(rec, n);
+}
+
+/************************ Replay *************************/
+static uint8_t get(void) {
+    return rep_pos < rep_len ? rep_log[rep_pos++] : 0;
+}
+
+static void replay(input_t *in) {
+    if (rep_run) {
+        rep_run--;
+        return;
+    }
+    if (rep_pos >= rep_len) {
+        rep_done = true;
+        *in = idle;
+        return;
+    }
+    uint8_t f = get();
+    if (!(f & 0x80)) {
+        rep_run = f; // This step and f more
+        return;
+    }
+    if (f & INPUT_F_BTN) in->buttons = get();
+    if (f & INPUT_F_XS) in->joy_x += (int8_t)get();
+    if (f & INPUT_F_XL) {
+        uint16_t v = get();
+        in->joy_x = (int16_t)(v | get() << 8);
+    }
+    if (f & INPUT_F_YS) in->joy_y += (int8_t)get();
+    if (f & INPUT_F_YL) {
+        uint16_t v = get();
+        in->joy_y = (int16_t)(v | get() << 8);
+    }
+}
+
+/************************ Control Functions *************************/
+void input_init(void) {
+    mode = live_md;
+    cur = prev = idle;
+}
+
+void input_record(uint8_t *buf, uint32_t size) {
+    input_init();
+    if (!buf) return;
+    rec_buf = buf;
+    rec_size = size;
+    rec_len = 0;
+    rec_run = 0;
+    mode = record_md;
+}
+
+uint32_t input_record_len(void) {
+    if (mode == record_md) flush_run();
+    return rec_len;
+}
+
+void input_replay(const uint8_t *log, uint32_t len) {
+    input_init();
+    rep_log = log;
+    rep_len = log ? len : 0;
+    rep_pos = 0;
+    rep_run = 0;
+    rep_done = false;
+    mode = replay_md;
+}
+
+bool input_replay_done(void) {
+    return mode == replay_md && rep_done;
+}
+
+void input_set_bot(input_bot_t b) {
+    bot = b;
+}
+
+input_bot_t input_get_bot(void) {
+    return bot;
+}
+
+/************************ Tick Function *************************/
+void input_tick(void) {
+    switch (mode) {
+        case live_md:
+            sample(&cur);
+            if (bot) bot(&cur);
+            break;
+        case record_md:
+            sample(&cur);
+            if (bot) bot(&cur);
+            record(&cur);
+            prev = cur;
+            break;
+        case replay_md:
+            replay(&cur);
+            break;
+    }
+}
+
+/************************ Status Functions *************************/
+bool input_down(uint8_t buttons) {
+    return cur.buttons & buttons;
+}
+
+void input_get_joy(int32_t *x, int32_t *y) {
+    if (x) *x = cur.joy_x;
+    if (y) *y = cur.joy_y;
+}
+
+bool input_latch_joy(int32_t *x, int32_t *y) {
+    if (mode == replay_md || bot) return false;
+    joy_get_displacement(x, y);
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Game input for each physics step: buttons and joystick, sampled once
+// by input_tick() and read by the game code instead of the hardware. The
+// samples can be recorded to a compact log and replayed later in place
+// of the hardware, which drives the game through exactly the same steps.
+//
+// Log format, one record per run or change:
+//   0nnnnnnn         the current input repeats for n+1 steps
+//   1fffffff [data]  the input changed for one step; the bits f select
+//                    the fields that follow, in this order:
+//     INPUT_F_BTN    buttons, 1 byte
+//     INPUT_F_XS     joystick x change, 1 byte signed
+//     INPUT_F_XL     joystick x, 2 bytes little endian
+//     INPUT_F_YS     joystick y change, 1 byte signed
+//     INPUT_F_YL     joystick y, 2 bytes little endian
+// Before the first step all buttons are released and the joystick is
+// centered.
+
+// Buttons (bits of input_t.buttons, set when pressed)
+#define INPUT_A      0x01
+#define INPUT_B      0x02
+#define INPUT_START  0x04
+#define INPUT_SELECT 0x08
+#define INPUT_OPTION 0x10
+
+// Fields of a change record
+#define INPUT_F_BTN 0x01
+#define INPUT_F_XS  0x02
+#define INPUT_F_XL  0x04
+#define INPUT_F_YS  0x08
+#define INPUT_F_YL  0x10
+
+// Input for one step
+typedef struct {
+    uint8_t buttons;   // INPUT_* bits
+    int16_t joy_x;     // Joystick displacement, see joy_get_displacement()
+    int16_t joy_y;
+} input_t;
+
+// Bot that sets the input for the next step, see input_set_bot()
+typedef void (*input_bot_t)(input_t *in);
+
+/************************ Function Prototypes *************************/
+
+// Read live input from the hardware, without recording.
+void input_init(void);
+
+// Read live input and record it to a log.
+// buf: buffer for the log; size: size of buf in bytes.
+// Recording stops if the buffer fills.
+void input_record(uint8_t *buf, uint32_t size);
+
+// Get the length of the log recorded so far in bytes (the log stays
+// open for more steps).
+uint32_t input_record_len(void);
+
+// Replay input from a log instead of the hardware.
+// log: log from input_record(); len: length of log in bytes.
+void input_replay(const uint8_t *log, uint32_t len);
+
+// Return true if replaying and the log has ended. The input is then
+// idle (nothing pressed, joystick centered).
+bool input_replay_done(void);
+
+// Let a bot play: it is called with the live input of every step and may
+// change it (NULL for none). What the bot does is recorded like a player's
+// input. Replayed input is not changed.
+void input_set_bot(input_bot_t bot);
+
+// Get the bot set by input_set_bot(), or NULL if none
+input_bot_t input_get_bot(void);
+
+// Sample the input for the next physics step (call once per step,
+// before game_tick()).
+void input_tick(void);
+
+// Return true if any of the buttons is pressed in this step.
+bool input_down(uint8_t buttons);
+
+// Get the joystick displacement for this step
+void input_get_joy(int32_t *x, int32_t *y);
+
+// Read the joystick now, for drawing only (late latch), if the input is
+// live: not replayed and no bot playing. It may be called from another
+// task than input_tick().
+// Return false if the input is not live (*x and *y are not set).
+bool input_latch_joy(int32_t *x, int32_t *y);
+
+#endif // INPUT_H
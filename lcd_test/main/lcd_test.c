@@ -10,6 +10,7 @@
 #include "esp_timer.h" // esp_timer_get_time
 
 #include "lcd.h"
+#include "asset.h"
 #include "crosshair.h"
 #include "peppers.h"
 
@@ -440,6 +441,26 @@ int64_t lcd_test_drawRGBBitmap(void) {
 	return diffTick;
 }
 
+// Draw the "peppers" image straight from the memory mapped asset partition.
+int64_t lcd_test_drawAsset(void) {
+	int64_t startTick, endTick, diffTick;
+	asset_t img;
+
+	if (asset_get("peppers", &img)) return 0;
+
+	startTick = esp_timer_get_time();
+	if (img.fmt == ASSET_FMT_RLE565)
+		lcd_drawImageRLE(0, 0, img.data, img.w, img.h);
+	else
+		lcd_drawRGBBitmap(0, 0, img.data, img.w, img.h);
+	endTick = esp_timer_get_time();
+
+	lcd_writeFrame();
+	diffTick = endTick - startTick;
+	PRINT_TIME(diffTick);
+	return diffTick;
+}
+
 //----------------------------------------------------------------------------//
 // Rectangle variants that specify two diagonal corners
 //----------------------------------------------------------------------------//
@@ -782,6 +803,7 @@ int64_t lcd_test_wrapAround(void) {
 void lcd_test_all(void *pvParameters)
 {
 	lcd_init();
+	asset_init(NULL);
 	for (;;) {
 		lcd_test_colorBar(); WAIT;
 		lcd_test_colorBand(); WAIT;
@@ -800,6 +822,7 @@ void lcd_test_all(void *pvParameters)
 		lcd_test_fillArrow(); WAIT;
 		lcd_test_drawBitmap(); WAIT;
 		lcd_test_drawRGBBitmap(); WAIT;
+		lcd_test_drawAsset(); WAIT;
 		lcd_test_drawRect2(); WAIT;
 		lcd_test_fillRect2(); WAIT;
 		lcd_test_drawRoundRect2(); WAIT;
@@ -0,0 +1,100 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h> // memcmp
+
+#include "phys.h"
+#include "brick.h"
+#include "level.h"
+
+// Little endian 16-bit value
+#define GET16(p) ((uint16_t)((p)[0] | (p)[1] << 8))
+
+/************************ Pack Functions *************************/
+int32_t level_open(level_pack_t *pack, const void *data, uint32_t size) {
+    if (!pack || !data || size < LEVEL_HDR_SZ) return -1;
+
+    const uint8_t *d = data;
+    if (memcmp(d, LEVEL_MAGIC, 4) || d[4] != LEVEL_VERSION) return -1;
+    uint16_t count = GET16(d + 6);
+    if (LEVEL_HDR_SZ + 2*(uint32_t)count > size) return -1;
+
+    pack->data = d;
+    pack->size = size;
+    pack->count = count;
+    return 0;
+}
+
+uint32_t level_count(const level_pack_t *pack) {
+    return pack ? pack->count : 0;
+}
+
+bool level_fits(int rows, int cols, int sx, int sy, int h) {
+    return rows >= 1 && cols >= 1 && h >= 1 &&
+           (cols + 1) * sx + cols <= LCD_W && // Bricks at least 1 wide
+           rows * (h + sy) <= LCD_H;
+}
+
+/************************ Level Decoding *************************/
+// Reader of the nibble stream of a level
+typedef struct {
+    const uint8_t *p, *end; // Next stored byte, end of the pack
+    bool rle;               // Bytes are in RLE packets
+    uint8_t left;           // Bytes left in the packet
+    bool run;               // The packet repeats one byte
+    uint16_t byte;          // Current byte, bit 8 set while its high
+                            // nibble is unread
+    bool bad;               // Read past the end or a bad packet
+} reader_t;
+
+static uint8_t get_byte(reader_t *rd) {
+    if (rd->rle && !rd->left && rd->p < rd->end) { // Next packet
+        rd->left = (*rd->p & 0x7F) + 1;
+        rd->run = *rd->p++ & 0x80;
+    }
+    if (rd->p >= rd->end) {
+        rd->bad = true;
+        return 0;
+    }
+    if (rd->left) rd->left--;
+    if (rd->run && rd->left) return *rd->p; // Stays on the repeated byte
+    return *rd->p++;
+}
+
+static uint8_t get_nibble(reader_t *rd) {
+    if (rd->byte & 0x100) {
+        rd->byte &= 0xFF;
+        return rd->byte >> 4;
+    }
+    rd->byte = get_byte(rd) | 0x100;
+    return rd->byte & 0xF;
+}
+
+int32_t level_load(const level_pack_t *pack, uint32_t index,
+                   brick_grid_t *grid) {
+    if (!pack || !grid || index >= pack->count) return -1;
+
+    uint32_t pos = GET16(pack->data + LEVEL_HDR_SZ + 2*index);
+    if (pos + LEVEL_REC_SZ > pack->size) return -1;
+    const uint8_t *rec = pack->data + pos;
+    int rows = rec[0], cols = rec[1];
+    uint8_t flags = rec[2];
+    if (rows > MAX_BRICK_ROWS || cols > MAX_BRICK_COLS ||
+        !level_fits(rows, cols, rec[3], rec[4], rec[5]))
+        return -1;
+
+    bricks_init_layout(grid, rows, cols, rec[3], rec[4], phys_from_int(rec[5]));
+
+    reader_t rd = {rec + LEVEL_REC_SZ, pack->data + pack->size,
+                   flags & LEVEL_RLE, 0, false, 0, false};
+    int stored = flags & LEVEL_MIRROR ? (cols + 1) / 2 : cols;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < stored; c++) {
+            uint8_t color = get_nibble(&rd);
+            uint8_t hp = flags & LEVEL_HP ? get_nibble(&rd) : 1;
+            uint8_t cell = color ? BRICK_CELL(color, hp) : 0;
+            bricks_set_cell(grid, r, c, cell);
+            if (flags & LEVEL_MIRROR) bricks_set_cell(grid, r, cols - 1 - c, cell);
+        }
+    }
+    return rd.bad ? -1 : 0;
+}
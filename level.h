@@ -0,0 +1,80 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "brick.h"
+
+// Level packs: brick layouts in a compact binary form, decoded into the
+// brick grid when a level starts. A pack is read in place, from the asset
+// partition (a raw asset) or from the one linked into the program
+// (level_builtin), so nothing is allocated or copied to load a level.
+// Use host/level_pack.c to make a pack from a text file.
+//
+// Pack layout (little endian):
+//   header:  magic "LVLP", version, reserved (1 byte each), level count
+//            (2 bytes)
+//   offsets: level count offsets (2 bytes each) of the levels from the
+//            start of the pack, so a pack is at most 64 KB
+//   levels:  one record each
+//
+// Level record:
+//   rows, cols, flags, spacing x, spacing y, brick height in pixels
+//   (1 byte each), then the cells in row-major order as a stream of
+//   nibbles, two per byte, low nibble first. A cell is its color index
+//   (0 for no brick), followed with LEVEL_HP by its hit points (0 is
+//   taken as 1, otherwise every brick has one). With LEVEL_MIRROR only
+//   the left (cols+1)/2 cells of each row are stored, the right half is
+//   the mirror image. With LEVEL_RLE the stream bytes are stored as
+//   packets:
+//     0nnnnnnn  n+1 bytes follow
+//     1nnnnnnn  the next byte repeats n+1 times
+
+#define LEVEL_MAGIC "LVLP"
+#define LEVEL_VERSION 1
+#define LEVEL_HDR_SZ 8  // Pack header size
+#define LEVEL_REC_SZ 6  // Level record header size
+
+// Level flags
+#define LEVEL_RLE    0x01 // Stream bytes are run-length encoded
+#define LEVEL_HP     0x02 // Cells have hit points
+#define LEVEL_MIRROR 0x04 // Rows are stored up to the middle
+
+// Color letters of cells in level files, for palette index 1 and up
+#define LEVEL_COLOR_CODES "RWBGYCMAO"
+
+// Open level pack
+typedef struct {
+    const uint8_t *data; // Pack data
+    uint32_t size;       // Size of data in bytes
+    uint16_t count;      // Number of levels
+} level_pack_t;
+
+// Pack linked into the program
+extern const uint8_t level_builtin[];
+extern const uint32_t level_builtin_size;
+
+/************************ Function Prototypes *************************/
+
+// Open a level pack. The data must stay valid while the pack is used.
+// data, size: pack data and its size in bytes.
+// Return zero if successful, or non-zero if the data is not a pack.
+int32_t level_open(level_pack_t *pack, const void *data, uint32_t size);
+
+// Return the number of levels in a pack
+uint32_t level_count(const level_pack_t *pack);
+
+// Return true if a level layout fits on the screen: bricks at least one
+// pixel wide and high, and the last row above the bottom edge.
+// rows, cols: grid size; sx, sy: spacing; h: brick height, in pixels.
+bool level_fits(int rows, int cols, int sx, int sy, int h);
+
+// Decode a level into a brick grid. The work is proportional to the
+// number of cells.
+// index: level number, 0 to level_count()-1.
+// Return zero if successful, or non-zero if the level is missing, bad,
+// too large for the grid or off the screen (the grid is then undefined).
+int32_t level_load(const level_pack_t *pack, uint32_t index,
+                   brick_grid_t *grid);
+
+#endif // LEVEL_H
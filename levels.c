@@ -0,0 +1,32 @@
+// Generated by host/level_pack from levels/levels.txt, do not edit.
+#include <stdint.h>
+
+const uint8_t level_builtin[] = {
+    0x4c, 0x56, 0x4c, 0x50, 0x01, 0x00, 0x08, 0x00, 0x18, 0x00, 0x28, 0x00,
+    0x40, 0x00, 0x79, 0x00, 0x96, 0x00, 0xaa, 0x00, 0xd4, 0x00, 0xfa, 0x00,
+    0x04, 0x0a, 0x04, 0x06, 0x06, 0x14, 0x11, 0x11, 0x21, 0x22, 0x22, 0x33,
+    0x33, 0x13, 0x11, 0x11, 0x06, 0x0b, 0x04, 0x04, 0x04, 0x0e, 0x00, 0x00,
+    0x50, 0x00, 0x00, 0x95, 0x00, 0x50, 0x19, 0x00, 0x95, 0x11, 0x50, 0x19,
+    0x11, 0x95, 0x11, 0x11, 0x05, 0x0c, 0x03, 0x04, 0x04, 0x0c, 0x2f, 0x16,
+    0x00, 0x16, 0x00, 0x16, 0x00, 0x16, 0x00, 0x16, 0x00, 0x16, 0x00, 0x00,
+    0x17, 0x00, 0x17, 0x00, 0x17, 0x00, 0x17, 0x00, 0x17, 0x00, 0x17, 0x16,
+    0x00, 0x16, 0x00, 0x16, 0x00, 0x16, 0x00, 0x16, 0x00, 0x16, 0x00, 0x00,
+    0x17, 0x00, 0x17, 0x00, 0x17, 0x00, 0x17, 0x00, 0x17, 0x00, 0x17, 0x8b,
+    0x28, 0x06, 0x0a, 0x07, 0x05, 0x05, 0x0e, 0x85, 0x38, 0x83, 0x15, 0x01,
+    0x38, 0x15, 0x82, 0x29, 0x06, 0x38, 0x15, 0x29, 0x31, 0x31, 0x38, 0x15,
+    0x82, 0x29, 0x00, 0x38, 0x83, 0x00, 0x07, 0x0c, 0x07, 0x04, 0x06, 0x0a,
+    0x85, 0x14, 0x85, 0x00, 0x85, 0x23, 0x85, 0x00, 0x85, 0x14, 0x85, 0x00,
+    0x85, 0x32, 0x07, 0x0c, 0x07, 0x04, 0x04, 0x0c, 0x84, 0x00, 0x00, 0x16,
+    0x83, 0x00, 0x01, 0x16, 0x13, 0x82, 0x00, 0x08, 0x16, 0x13, 0x17, 0x00,
+    0x00, 0x16, 0x13, 0x17, 0x32, 0x82, 0x00, 0x02, 0x16, 0x13, 0x17, 0x83,
+    0x00, 0x01, 0x16, 0x13, 0x84, 0x00, 0x00, 0x16, 0x08, 0x0b, 0x07, 0x04,
+    0x04, 0x0c, 0x02, 0x00, 0x00, 0x14, 0x85, 0x00, 0x00, 0x14, 0x83, 0x00,
+    0x83, 0x14, 0x03, 0x00, 0x14, 0x14, 0x21, 0x88, 0x14, 0x00, 0x00, 0x84,
+    0x14, 0x01, 0x00, 0x14, 0x85, 0x00, 0x02, 0x14, 0x14, 0x00, 0x04, 0x0b,
+    0x03, 0x06, 0x04, 0x10, 0x20, 0x19, 0x00, 0x15, 0x00, 0x19, 0x00, 0x15,
+    0x00, 0x19, 0x00, 0x15, 0x29, 0x00, 0x25, 0x00, 0x29, 0x00, 0x25, 0x00,
+    0x29, 0x00, 0x25, 0x39, 0x00, 0x35, 0x00, 0x39, 0x00, 0x35, 0x00, 0x39,
+    0x00, 0x35, 0x8a, 0x48,
+};
+
+const uint32_t level_builtin_size = sizeof(level_builtin);
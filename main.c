@@ -2,15 +2,22 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/timers.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "driver/gpio.h"
 
 #include "hw.h"
 #include "lcd.h"
 #include "cursor.h"
 #include "sound.h"
 #include "pin.h"
+#include "input.h"
+#include "asset.h"
 #include "game.h"
+#include "telem.h"
+#include "governor.h"
+#include "render.h"
 #include "config.h"
 
 // sound support
@@ -20,9 +27,24 @@ static const char *TAG = "lab07";
 
 // The update period as an integer in ms
 #define PER_MS ((uint32_t)(CONFIG_GAME_TIMER_PERIOD*1000))
+// The physics step as an integer in us
+#define STEP_US ((int64_t)(CONFIG_PHYSICS_STEP*1000000))
 #define TIME_OUT 500 // ms
 
+#define REPLAY_NAME "replay" // Asset with an input log to replay
+#define LEVELS_NAME "levels" // Asset with a level pack (level.h)
+#define LOG_LINE 32 // Bytes per line of the printed input log
+
 #define CURSOR_SZ 0 // Cursor size (width & height) in pixels
+#define LATCH_MAX_US (2*PER_MS*1000) // Furthest the platform is latched ahead
+
+#define PAUSE_BLINK_MS 500 // "PAUSED" blink half period
+#define PAUSE_TEXT "PAUSED"
+#define PAUSE_FONT 2       // Font size of the text
+#define PAUSE_W (PAUSE_FONT*LCD_CHAR_W*(sizeof(PAUSE_TEXT)-1))
+#define PAUSE_H (PAUSE_FONT*LCD_CHAR_H)
+#define PAUSE_X ((LCD_W-PAUSE_W)/2)
+#define PAUSE_Y ((LCD_H-PAUSE_H)/2)
 
 //
 #define CHK_RET(x) ({                                           \
@@ -33,17 +55,79 @@ static const char *TAG = "lab07";
         ret_val;                                                \
     })
 
-TimerHandle_t update_timer; // Declare timer handle for update callback
+#define RENDER_CORE 1 // Other core from app_main
+#define RENDER_PRIO 2
+#define RENDER_STACK 4096
+#define SOUND_PRIO 1
+#define SOUND_STACK 2048
 
-volatile bool interrupt_flag;
+// Telemetry stages
+enum {
+	TS_TICK,    // Physics steps (game_tick)
+	TS_CURSOR,  // cursor_tick
+	TS_CLEAR,   // render_begin
+	TS_DRAW,    // game_draw
+	TS_PRESENT, // lcd_writeFrame(Rect)
+	TS_FRAME,   // Whole render frame
+	TS_LATENCY, // Platform input read to frame presented
+	TS_NUM
+};
+static const char *const ts_names[TS_NUM] =
+	{"tick", "cursor", "clear", "draw", "present", "frame", "latency"};
+
+TimerHandle_t update_timer; // Declare timer handle for update callback
+TaskHandle_t sim_task;      // Task woken by the update timer
+TaskHandle_t render_task;   // Task that draws and presents frames
+TaskHandle_t sound_task;    // Task that plays the sounds of game events
 
 uint32_t isr_triggered_count;
 uint32_t isr_handled_count;
 
-// Interrupt handler for game - use flag method
+// Everything the render task needs to draw one frame
+typedef struct {
+	game_frame_t game;
+	coord_t cx, cy; // Cursor position
+	bool overlay;   // Draw telemetry overlay
+	int64_t t_input; // Time the input of the last step was read (us)
+	int64_t t_sim;   // Time simulated up to (us)
+	uint8_t pause;   // PAUSE_* request, handled instead of drawing
+} frame_t;
+
+// Pause display requests to the render task
+enum {
+	PAUSE_OFF,   // Not paused, draw the game
+	PAUSE_ENTER, // Dim the last frame and show the text
+	PAUSE_SHOW,  // Show the text
+	PAUSE_HIDE,  // Hide the text
+};
+
+// Single-slot handoff from simulation to render, over three frame
+// buffers: the simulation fills one, the slot holds the latest completed
+// frame, and the render task draws from the third. Publishing and taking
+// a frame swap buffer pointers under the lock, so no frame is copied. If
+// the render task is still busy with a previous frame, the frame in the
+// slot is skipped and its buffer goes back to the simulation.
+static frame_t frames[3];
+static frame_t *fill = &frames[0]; // Filled by the simulation
+static frame_t *slot = &frames[1]; // Latest completed frame, if slot_full
+static frame_t *draw = &frames[2]; // Drawn by the render task
+static bool slot_full;
+static volatile bool render_stop;
+static volatile bool render_done;
+static portMUX_TYPE slot_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Game events for the sound task
+static event_ring_t sound_events;
+
+// Frame statistics
+static uint32_t frames_rendered;
+static uint32_t frames_skipped;
+static uint64_t render_tmax;
+
+// Timer callback for game - notify the simulation task
 void update() {
-	interrupt_flag = true;
 	isr_triggered_count++;
+	xTaskNotifyGive(sim_task);
 }
 
 // Draw the cursor on the screen
@@ -52,15 +136,236 @@ void cursor(coord_t x, coord_t y, color_t color)
 	coord_t s2 = CURSOR_SZ >> 1; // size div 2
 	lcd_drawHLine(x-s2, y,    CURSOR_SZ, color);
 	lcd_drawVLine(x,    y-s2, CURSOR_SZ, color);
+	if (CURSOR_SZ) render_add(x-s2, y-s2, CURSOR_SZ, CURSOR_SZ);
+}
+
+// Send the frame buffer to the display. Only the areas changed this
+// frame are sent, unless the present mode is interlaced and they cover
+// over half the screen: then one field of the frame is sent, and the
+// next frame that is not interlaced sends the whole frame, since the
+// other field may be stale.
+static void present(void)
+{
+	static bool half; // Last frame sent one field
+	render_box_t box[RENDER_MAX_DIRTY];
+	uint32_t n = render_dirty(box);
+	int32_t area = 0;
+
+	for (uint32_t i = 0; i < n; i++)
+		area += (int32_t)box[i].w * box[i].h;
+	if (lcd_getPresentMode() == PRESENT_INTERLACED && area > LCD_W*LCD_H/2) {
+		lcd_writeFrame();
+		half = true;
+	} else if (half) {
+		lcd_writeFrameRect(0, 0, LCD_W, LCD_H);
+		half = false;
+	} else {
+		for (uint32_t i = 0; i < n; i++)
+			lcd_writeFrameRect(box[i].x, box[i].y, box[i].w, box[i].h);
+	}
+}
+
+// Publish the frame filled by the simulation to the render task, and
+// give the simulation another buffer to fill. The changes of a skipped
+// frame are carried into the new one.
+static void frame_publish(void)
+{
+	bool skipped, game;
+	portENTER_CRITICAL(&slot_mux);
+	skipped = slot_full;
+	game = !fill->pause && !slot->pause; // Both are game frames
+	if (skipped && game) game_skip(&fill->game, &slot->game);
+	frame_t *f = slot;
+	slot = fill;
+	fill = f;
+	slot_full = true;
+	portEXIT_CRITICAL(&slot_mux);
+	if (skipped && game) frames_skipped++; // Pause frames aren't load
+	xTaskNotifyGive(render_task);
+}
+
+// Pause display, drawn straight into the frame buffer over the last
+// frame. Only the first request sends the whole frame; the blinks send
+// the text box.
+static void pause_draw(uint8_t req)
+{
+	static color_t under[PAUSE_W*PAUSE_H]; // Dimmed pixels under the text
+	color_t *fb = lcd_getFrameBuffer();
+	if (!fb) return;
+
+	if (req == PAUSE_ENTER) {
+		// Translucent black overlay: halve each RGB565 channel
+		for (uint32_t i = 0; i < LCD_W*LCD_H; i++)
+			fb[i] = (fb[i] >> 1) & 0x7BEF;
+		for (uint32_t y = 0; y < PAUSE_H; y++)
+			for (uint32_t x = 0; x < PAUSE_W; x++)
+				under[y*PAUSE_W+x] = fb[(PAUSE_Y+y)*LCD_W + PAUSE_X+x];
+	}
+	if (req == PAUSE_HIDE) {
+		for (uint32_t y = 0; y < PAUSE_H; y++)
+			for (uint32_t x = 0; x < PAUSE_W; x++)
+				fb[(PAUSE_Y+y)*LCD_W + PAUSE_X+x] = under[y*PAUSE_W+x];
+	} else {
+		lcd_setFontSize(PAUSE_FONT);
+		lcd_drawString(PAUSE_X, PAUSE_Y, PAUSE_TEXT, CONFIG_COLOR_STATUS);
+		lcd_setFontSize(1);
+	}
+	if (req == PAUSE_ENTER) lcd_writeFrameRect(0, 0, LCD_W, LCD_H);
+	else lcd_writeFrameRect(PAUSE_X, PAUSE_Y, PAUSE_W, PAUSE_H);
+}
+
+// Render task: draw each published frame into the frame buffer and send
+// it to the display. The SPI transfer of one frame overlaps simulation
+// of the next on the other core.
+static void render(void *pvParameters)
+{
+	uint64_t t1, t2;
+	uint32_t overruns, last_overruns = 0;
+	bool paused = false;
+
+	for (;;) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if (render_stop) break;
+
+		portENTER_CRITICAL(&slot_mux);
+		bool full = slot_full;
+		if (full) {
+			frame_t *f = draw;
+			draw = slot;
+			slot = f;
+		}
+		slot_full = false;
+		portEXIT_CRITICAL(&slot_mux);
+		if (!full) continue;
+		frame_t *frame = draw; // Ours until the next take
+
+		if (frame->pause) {
+			pause_draw(frame->pause);
+			paused = true;
+			continue;
+		}
+		if (paused) { // The frame buffer was drawn over, start clean
+			render_reset();
+			paused = false;
+		}
+
+		t1 = esp_timer_get_time();
+		int64_t ts = t1;
+		render_begin();
+		ts = telem_record(TS_CLEAR, ts);
+		game_draw_scene(&frame->game);
+		if (governor_hud()) game_draw_stats(&frame->game);
+		cursor(frame->cx, frame->cy, CONFIG_COLOR_CURSOR);
+		if (frame->overlay && governor_hud()) {
+			coord_t oy = LCD_H-(TS_NUM+1)*LCD_CHAR_H;
+			telem_draw(0, oy, CONFIG_COLOR_STATUS);
+			render_add(0, oy, LCD_W, (TS_NUM+1)*LCD_CHAR_H);
+		}
+		// Late latch: read the joystick as late as possible and move the
+		// platform on from where the simulation left it
+		int64_t t_input = frame->t_input;
+		int32_t jx, jy;
+		if (CONFIG_LATE_LATCH && input_latch_joy(&jx, &jy)) {
+			t_input = esp_timer_get_time();
+			int64_t ahead = t_input - frame->t_sim;
+			if (ahead < 0) ahead = 0;
+			if (ahead > LATCH_MAX_US) ahead = LATCH_MAX_US;
+			platform_latch(&frame->game.platform, jx, phys_from_us(ahead));
+		}
+		game_draw_platform(&frame->game);
+		ts = telem_record(TS_DRAW, ts);
+		present();
+		ts = telem_record(TS_PRESENT, ts);
+		telem_record(TS_LATENCY, t_input);
+		telem_record(TS_FRAME, t1);
+		t2 = esp_timer_get_time() - t1;
+		if (t2 > render_tmax) render_tmax = t2;
+		frames_rendered++;
+
+		overruns = telem_get_missed() + frames_skipped;
+		governor_frame(t2, overruns - last_overruns);
+		last_overruns = overruns;
+	}
+	render_done = true;
+	xTaskNotifyGive(sim_task);
+	vTaskDelete(NULL);
+}
+
+// Sound task: play the sounds of the game events pushed since it last
+// ran. The simulation wakes it after physics steps that pushed events.
+static void sound_consumer(void *pvParameters)
+{
+	event_t e;
+	for (;;) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		while (event_pop(&sound_events, &e))
+			game_sound(&e);
+	}
+}
+
+// OPTION or MENU changed while paused - wake the simulation task
+static void IRAM_ATTR pause_isr(void *arg)
+{
+	BaseType_t woken = pdFALSE;
+	vTaskNotifyGiveFromISR(sim_task, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+// Wait until the render task has taken the frame in the slot
+static void frame_drain(void)
+{
+	for (;;) {
+		portENTER_CRITICAL(&slot_mux);
+		bool full = slot_full;
+		portEXIT_CRITICAL(&slot_mux);
+		if (!full) return;
+		vTaskDelay(1);
+	}
+}
+
+// Pause until OPTION is pressed again, or MENU. The simulation timer is
+// stopped and the task sleeps until a button interrupt or the next blink.
+// The render task dims the last frame drawn once and then only blinks
+// the text, so almost nothing runs or goes over the bus while paused.
+static void pause_game(void)
+{
+	xTimerStop(update_timer, pdMS_TO_TICKS(TIME_OUT));
+	frame_drain(); // Dim a frame the player has seen
+	fill->pause = PAUSE_ENTER;
+	frame_publish();
+	ulTaskNotifyTake(pdTRUE, 0); // Drop a tick from before the stop
+	gpio_intr_enable(HW_BTN_OPTION);
+	gpio_intr_enable(HW_BTN_MENU);
+
+	bool show = true, held = true; // OPTION still held from the press
+	int64_t blink = esp_timer_get_time() + PAUSE_BLINK_MS*1000;
+	while (pin_get_level(HW_BTN_MENU)) {
+		int64_t wait = blink - esp_timer_get_time();
+		if (wait <= 0) {
+			blink += PAUSE_BLINK_MS*1000;
+			show = !show;
+			fill->pause = show ? PAUSE_SHOW : PAUSE_HIDE;
+			frame_publish();
+			continue;
+		}
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait/1000) + 1);
+		bool opt = !pin_get_level(HW_BTN_OPTION);
+		if (opt && !held) break;
+		held = opt;
+	}
+	gpio_intr_disable(HW_BTN_OPTION);
+	gpio_intr_disable(HW_BTN_MENU);
+	ulTaskNotifyTake(pdTRUE, 0); // Drop wakes from button bounces
+	xTimerStart(update_timer, pdMS_TO_TICKS(TIME_OUT));
 }
 
 // Main application
 void app_main(void)
 {
-	// ISR flag and counts
-	interrupt_flag = false;
+	// Counts
 	isr_triggered_count = 0;
 	isr_handled_count = 0;
+	sim_task = xTaskGetCurrentTaskHandle();
 
 	// Initialization
 	lcd_init();
@@ -68,7 +373,21 @@ void app_main(void)
 	lcd_fillScreen(CONFIG_COLOR_BACKGROUND);
 	CHK_RET(cursor_init(PER_MS));
 	sound_init(MISSILELAUNCH_SAMPLE_RATE);
-	game_init();
+
+	// Levels from the asset partition if there, or the built-in pack
+	asset_t level_pack;
+	bool assets = !asset_init(NULL);
+	if (assets && !asset_get(LEVELS_NAME, &level_pack) &&
+			game_levels(level_pack.data, level_pack.size))
+		ESP_LOGE(TAG, "Bad level pack, using built-in levels");
+
+	event_init(&sound_events);
+	game_events(&sound_events);
+	game_restart();
+	game_stress(CONFIG_STRESS_BALLS);
+	render_init(CONFIG_COLOR_BACKGROUND);
+	telem_init(ts_names, TS_NUM);
+	governor_init(PER_MS*1000);
 
 	// Configure I/O pins for buttons
 	pin_reset(HW_BTN_A);
@@ -84,6 +403,41 @@ void app_main(void)
 	pin_reset(HW_BTN_START);
 	pin_input(HW_BTN_START, true);
 
+	// OPTION and MENU wake the simulation task while paused. The
+	// interrupts are only enabled during a pause.
+	gpio_install_isr_service(0);
+	gpio_set_intr_type(HW_BTN_OPTION, GPIO_INTR_ANYEDGE);
+	gpio_set_intr_type(HW_BTN_MENU, GPIO_INTR_ANYEDGE);
+	gpio_isr_handler_add(HW_BTN_OPTION, pause_isr, NULL);
+	gpio_isr_handler_add(HW_BTN_MENU, pause_isr, NULL);
+	gpio_intr_disable(HW_BTN_OPTION);
+	gpio_intr_disable(HW_BTN_MENU);
+
+	// Input: hold OPTION at start to replay the input log from the asset
+	// partition (a raw asset named REPLAY_NAME), so a session can be run
+	// again step for step. Otherwise the live input is recorded.
+	static uint8_t input_log[CONFIG_INPUT_LOG_SIZE];
+	asset_t replay_log;
+	bool replay = !pin_get_level(HW_BTN_OPTION) && assets &&
+		!asset_get(REPLAY_NAME, &replay_log);
+	if (replay) input_replay(replay_log.data, replay_log.size);
+	else input_record(input_log, sizeof(input_log));
+	if (CONFIG_AUTOPLAY) input_set_bot(game_autoplay);
+
+	// Start render task on the other core
+	if (xTaskCreatePinnedToCore(render, "render", RENDER_STACK, NULL,
+			RENDER_PRIO, &render_task, RENDER_CORE) != pdPASS) {
+		ESP_LOGE(TAG, "Error creating render task");
+		return;
+	}
+
+	// Sounds are started from their own task, not from the physics
+	if (xTaskCreatePinnedToCore(sound_consumer, "sound", SOUND_STACK, NULL,
+			SOUND_PRIO, &sound_task, RENDER_CORE) != pdPASS) {
+		ESP_LOGE(TAG, "Error creating sound task");
+		return;
+	}
+
 	// Initialize update timer
 	update_timer = xTimerCreate(
 		"update_timer",        // Text name for the timer.
@@ -101,35 +455,103 @@ void app_main(void)
 		return;
 	}
 
-	// Main game loop
+	// Main game loop (simulation)
+	// Physics runs in fixed steps for the real time elapsed since the last
+	// frame. The task blocks between timer periods, leaving the core to
+	// other tasks. Rendering happens in the render task.
 	uint64_t t1, t2, tmax = 0; // For hardware timer values
-	coord_t x, y; // For cursor position
-	while (pin_get_level(HW_BTN_MENU)) // while MENU button not pressed
+	int64_t acc = 0; // Simulation time owed in us
+	int64_t last = esp_timer_get_time();
+	uint32_t steps_dropped = 0;
+	int64_t t_input = 0; // Time the input of the last step was read
+	bool overlay = false;
+	bool btn_b = false;
+	bool btn_select = false;
+	bool btn_option = !pin_get_level(HW_BTN_OPTION); // Held for replay
+	// Run until MENU is pressed, or the replayed log ends
+	while (pin_get_level(HW_BTN_MENU) && !input_replay_done())
 	{
-		while (!interrupt_flag) ;
+		uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 		t1 = esp_timer_get_time();
-		interrupt_flag = false;
 		isr_handled_count++;
+		if (ticks > 1) telem_missed(ticks-1);
 
-#ifndef CONFIG_ERASE
-		lcd_fillScreen(CONFIG_COLOR_BACKGROUND);
-#endif // CONFIG_ERASE
-		game_tick();
+		acc += t1 - last;
+		last = t1;
+		if (acc >= STEP_US) t_input = t1;
+		uint32_t steps = 0;
+		while (acc >= STEP_US && steps < CONFIG_PHYSICS_MAX_STEPS) {
+			input_tick();
+			game_tick(PHYS(CONFIG_PHYSICS_STEP));
+			acc -= STEP_US;
+			steps++;
+		}
+		if (acc >= STEP_US) { // Too far behind, drop the time
+			steps_dropped += acc / STEP_US;
+			acc %= STEP_US;
+		}
+		if (!event_empty(&sound_events)) xTaskNotifyGive(sound_task);
+		int64_t ts = telem_record(TS_TICK, t1);
 		cursor_tick();
-		cursor_get_pos(&x, &y);
-#ifdef CONFIG_ERASE
-		static coord_t lx = -1, ly = -1;
-		if (x != lx || y != ly) {
-			cursor(lx,  ly, CONFIG_COLOR_BACKGROUND);
-			lx = x; ly = y;
+		telem_record(TS_CURSOR, ts);
+
+		// B button toggles the telemetry overlay
+		bool b = input_down(INPUT_B);
+		if (b && !btn_b) overlay = !overlay;
+		btn_b = b;
+
+		// SELECT toggles the autoplay bot
+		bool sel = input_down(INPUT_SELECT);
+		if (sel && !btn_select)
+			input_set_bot(input_get_bot() ? NULL : game_autoplay);
+		btn_select = sel;
+
+		// OPTION pauses the game (read live, so replays can be paused)
+		bool opt = !pin_get_level(HW_BTN_OPTION);
+		if (opt && !btn_option) {
+			pause_game();
+			last = esp_timer_get_time(); // Don't simulate the pause
+			acc = 0;
+			opt = !pin_get_level(HW_BTN_OPTION);
 		}
-#endif // CONFIG_ERASE
-		cursor(x, y, CONFIG_COLOR_CURSOR);
-		lcd_writeFrame();
+		btn_option = opt;
+
+		// Effects density follows the governor
+		game_particle_cap(governor_effect_scale() * CONFIG_MAX_PARTICLES);
+		frame_t *f = fill;
+		cursor_get_pos(&f->cx, &f->cy);
+		f->overlay = overlay;
+		f->t_input = t_input;
+		f->t_sim = t1 - acc;
+		f->pause = PAUSE_OFF;
+		game_snapshot(&f->game);
+		frame_publish();
+
 		t2 = esp_timer_get_time() - t1;
 		if (t2 > tmax) tmax = t2;
 	}
+	xTimerStop(update_timer, pdMS_TO_TICKS(TIME_OUT));
+	render_stop = true;
+	xTaskNotifyGive(render_task);
+	while (!render_done) // Wait for render task to exit
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	vTaskDelete(sound_task);
+
 	printf("Handled %lu of %lu interrupts\n", isr_handled_count, isr_triggered_count);
-	printf("WCET us:%llu\n", tmax);
+	printf("Rendered %lu frames, skipped %lu\n", frames_rendered, frames_skipped);
+	printf("WCET us:%llu (sim), %llu (render)\n", tmax, render_tmax);
+	printf("Dropped %lu physics steps\n", steps_dropped);
+	printf("Dropped %lu sound events\n", sound_events.dropped);
+	telem_print();
+	if (replay) {
+		printf("Replayed input log, %lu bytes\n", replay_log.size);
+	} else {
+		// Save as a binary file (xxd -r -p) and pack as REPLAY_NAME
+		uint32_t len = input_record_len();
+		printf("Input log, %lu bytes:\n", len);
+		for (uint32_t i = 0; i < len; i++)
+			printf(i % LOG_LINE == LOG_LINE-1 || i == len-1 ? "%02x\n" : "%02x",
+				input_log[i]);
+	}
 	sound_deinit();
 }
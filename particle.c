@@ -0,0 +1,132 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lcd.h"
+#include "particle.h"
+#include "render.h"
+
+#define SCREEN_WIDTH LCD_W
+#define SCREEN_HEIGHT LCD_H
+
+#define SPEED 120   // Largest burst speed along each axis (pixels/s)
+#define GRAVITY 400 // Downward acceleration (pixels/s^2)
+#define SEED 1
+
+// Pseudo-random number 0 to n-1, the same sequence every game
+static uint32_t burst_rand(particle_set_t *set, uint32_t n)
+{
+    set->seed = set->seed * 1103515245 + 12345;
+    return (set->seed >> 16) % n;
+}
+
+// Move the last live particle into slot i
+static void remove_at(particle_set_t *set, int32_t i)
+{
+    int32_t last = --set->count;
+    set->x[i] = set->x[last];
+    set->y[i] = set->y[last];
+    set->dx[i] = set->dx[last];
+    set->dy[i] = set->dy[last];
+    set->color[i] = set->color[last];
+    set->life[i] = set->life[last];
+}
+
+/************************ Initialization *************************/
+void particles_init(particle_set_t *set) {
+    if (!set) return;
+
+    set->count = 0;
+    set->cap = CONFIG_MAX_PARTICLES;
+    set->seed = SEED;
+}
+
+/************************ Control Functions *************************/
+void particles_clear(particle_set_t *set) {
+    if (!set) return;
+
+    set->count = 0;
+}
+
+void particles_set_cap(particle_set_t *set, uint32_t cap) {
+    if (!set) return;
+
+    if (cap > CONFIG_MAX_PARTICLES) cap = CONFIG_MAX_PARTICLES;
+    set->cap = cap;
+    if (set->count > cap) set->count = cap;
+}
+
+uint32_t particles_burst(particle_set_t *set, phys_t x, phys_t y,
+                         phys_t w, phys_t h, color_t color, uint32_t n) {
+    if (!set || set->count >= set->cap) return 0;
+
+    if (n > (uint32_t)(set->cap - set->count)) n = set->cap - set->count;
+    phys_t cx = x + w/2, cy = y + h/2;
+    for (uint32_t k = 0; k < n; k++) {
+        int32_t i = set->count++;
+        set->x[i] = cx;
+        set->y[i] = cy;
+        set->dx[i] = phys_from_int((int32_t)burst_rand(set, 2*SPEED+1) - SPEED);
+        set->dy[i] = phys_from_int((int32_t)burst_rand(set, 2*SPEED+1) - SPEED);
+        set->color[i] = color;
+        set->life[i] = PARTICLE_LIFE/2 + burst_rand(set, PARTICLE_LIFE/2 + 1);
+    }
+    return n;
+}
+
+/************************ Tick Function *************************/
+void particles_tick(particle_set_t *set, phys_t dt) {
+    if (!set || !set->count) return;
+
+    phys_t gdt = phys_mul(phys_from_int(GRAVITY), dt);
+    phys_t right = phys_from_int(SCREEN_WIDTH);
+    phys_t bottom = phys_from_int(SCREEN_HEIGHT);
+    for (int32_t i = 0; i < set->count; ) {
+        set->dy[i] += gdt;
+        set->x[i] += phys_mul(set->dx[i], dt);
+        set->y[i] += phys_mul(set->dy[i], dt);
+        if (!--set->life[i] || set->x[i] < 0 || set->x[i] >= right ||
+            set->y[i] >= bottom) {
+            remove_at(set, i); // Slot i now holds another particle
+            continue;
+        }
+        i++;
+    }
+}
+
+/************************ Draw Function *************************/
+void particles_draw(const particle_set_t *set) {
+    if (!set || !set->count) return;
+
+    // Bounding box of the particles in each band
+    coord_t x0[PARTICLE_BANDS], y0[PARTICLE_BANDS];
+    coord_t x1[PARTICLE_BANDS], y1[PARTICLE_BANDS];
+    for (int32_t b = 0; b < PARTICLE_BANDS; b++) {
+        x0[b] = SCREEN_WIDTH; y0[b] = SCREEN_HEIGHT;
+        x1[b] = y1[b] = -1;
+    }
+    color_t *fb = lcd_getFrameBuffer();
+    for (int32_t i = 0; i < set->count; i++) {
+        coord_t x = phys_floor(set->x[i]);
+        coord_t y = phys_floor(set->y[i]);
+        // Above the top, or partly off the right or bottom edge
+        if (x < 0 || y < 0 || x > SCREEN_WIDTH - PARTICLE_SIZE ||
+            y > SCREEN_HEIGHT - PARTICLE_SIZE) continue;
+        if (fb) {
+            color_t *p = fb + y*SCREEN_WIDTH + x;
+            for (int32_t r = 0; r < PARTICLE_SIZE; r++, p += SCREEN_WIDTH)
+                for (int32_t c = 0; c < PARTICLE_SIZE; c++)
+                    p[c] = set->color[i];
+        } else {
+            lcd_fillRect(x, y, PARTICLE_SIZE, PARTICLE_SIZE, set->color[i]);
+        }
+        int32_t b = y * PARTICLE_BANDS / SCREEN_HEIGHT;
+        if (x < x0[b]) x0[b] = x;
+        if (y < y0[b]) y0[b] = y;
+        if (x > x1[b]) x1[b] = x;
+        if (y > y1[b]) y1[b] = y;
+    }
+    for (int32_t b = 0; b < PARTICLE_BANDS; b++)
+        if (x1[b] >= 0)
+            render_add(x0[b], y0[b], x1[b] - x0[b] + PARTICLE_SIZE,
+                       y1[b] - y0[b] + PARTICLE_SIZE);
+}
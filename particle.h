@@ -0,0 +1,68 @@
+#ifndef PARTICLE_H
+#define PARTICLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lcd.h"
+#include "phys.h"
+#include "config.h"
+
+// Particles for effects (brick-break bursts). The pool has a fixed
+// capacity and is stored as a structure of arrays, like the ball set
+// (balls.h). Live particles are kept packed at the front of the arrays:
+// a particle that dies is replaced by the last one, so the update and
+// draw loops run over slots 0 to count-1 with no gaps and nothing is
+// allocated while the game runs.
+//
+// The cap limits the particles in use below the capacity, so the density
+// of effects can be scaled down (see governor_effect_scale()). Bursts
+// are cut to the room left under the cap.
+
+#define PARTICLE_SIZE  2   // Width and height of a particle in pixels
+#define PARTICLE_BURST 12  // Particles in the burst of a broken brick
+#define PARTICLE_LIFE  120 // Longest life in physics steps
+#define PARTICLE_BANDS 4   // Screen bands with a dirty box of their own
+
+typedef struct {
+    phys_t x[CONFIG_MAX_PARTICLES];      // x positions
+    phys_t y[CONFIG_MAX_PARTICLES];      // y positions
+    phys_t dx[CONFIG_MAX_PARTICLES];     // x velocities
+    phys_t dy[CONFIG_MAX_PARTICLES];     // y velocities
+    color_t color[CONFIG_MAX_PARTICLES]; // Colors
+    uint8_t life[CONFIG_MAX_PARTICLES];  // Steps left to live
+    uint16_t count;                      // Live particles, slots 0 to count-1
+    uint16_t cap;                        // Most particles in use
+    uint32_t seed;                       // Pseudo-random state for bursts
+} particle_set_t;
+
+/************************ Function Prototypes *************************/
+
+// Initialize an empty particle set with the cap at the capacity
+void particles_init(particle_set_t *set);
+
+// Remove every particle, keeping the cap
+void particles_clear(particle_set_t *set);
+
+// Set the most particles in use, 0 to CONFIG_MAX_PARTICLES. Live
+// particles over a lower cap are removed.
+void particles_set_cap(particle_set_t *set, uint32_t cap);
+
+// Spawn a burst of particles from a box, flying out from its center.
+// x, y, w, h: box (e.g. a broken brick); color: particle color;
+// n: particles wanted.
+// Return the number of particles spawned.
+uint32_t particles_burst(particle_set_t *set, phys_t x, phys_t y,
+                         phys_t w, phys_t h, color_t color, uint32_t n);
+
+// Move the particles by dt seconds under gravity and remove the ones
+// that died or left the screen (call every physics step).
+void particles_tick(particle_set_t *set, phys_t dt);
+
+// Draw the live particles (call every frame). Pixels are written straight
+// to the frame buffer when there is one. The screen is cut into
+// PARTICLE_BANDS horizontal bands, and the bounding box of the particles
+// in each band is recorded with the render registry, so distant bursts
+// don't make one box over most of the screen.
+void particles_draw(const particle_set_t *set);
+
+#endif // PARTICLE_H
@@ -0,0 +1,120 @@
+#ifndef PHYS_H_
+#define PHYS_H_
+
+#include <stdint.h>
+#include <math.h>
+
+#include "config.h"
+
+// Number type for game physics (positions, velocities, sizes, times).
+//
+// By default this is Q16.16 fixed point: a 32-bit integer with 16 bits of
+// fraction. Only integer operations are used, so the results are the same
+// bit for bit on the ESP32 and on a host, don't depend on compiler flags
+// or the FPU, and can be computed in an ISR. Define CONFIG_PHYSICS_FLOAT
+// to build the same code with float instead (for comparison).
+//
+// Fixed point range is about +-32767 with a resolution of 1/65536.
+// Products of two values that may be large (squared distances) use the
+// wide type phys2_t.
+
+#ifndef CONFIG_PHYSICS_FLOAT
+
+#define PHYS_FRAC 16
+
+typedef int32_t phys_t;  // Q16.16
+typedef int64_t phys2_t; // Q32.32, product of two phys_t
+
+#define PHYS_ONE ((phys_t)1 << PHYS_FRAC)
+#define PHYS_MAX INT32_MAX
+#define PHYS_MIN INT32_MIN
+
+// Constant from a float expression, rounded (evaluated at compile time)
+#define PHYS(f) ((phys_t)((f) * PHYS_ONE + ((f) < 0 ? -0.5 : 0.5)))
+
+static inline phys_t phys_from_int(int32_t i) { return i * PHYS_ONE; }
+// Round toward minus infinity
+static inline int32_t phys_floor(phys_t a) { return a >> PHYS_FRAC; }
+static inline int32_t phys_ceil(phys_t a) { return (phys_t)(((int64_t)a + PHYS_ONE - 1) >> PHYS_FRAC); }
+static inline float phys_to_float(phys_t a) { return a / (float)PHYS_ONE; }
+// Seconds from microseconds (a time from esp_timer_get_time())
+static inline phys_t phys_from_us(int32_t us) { return (phys_t)(((int64_t)us << PHYS_FRAC) / 1000000); }
+
+static inline phys_t phys_sat(int64_t a)
+{
+    return a > PHYS_MAX ? PHYS_MAX : a < PHYS_MIN ? PHYS_MIN : (phys_t)a;
+}
+
+static inline phys_t phys_mul(phys_t a, phys_t b)
+{
+    return (phys_t)(((int64_t)a * b) >> PHYS_FRAC);
+}
+
+// Saturates on overflow and division by zero
+static inline phys_t phys_div(phys_t a, phys_t b)
+{
+    if (b == 0) return a < 0 ? PHYS_MIN : PHYS_MAX;
+    return phys_sat(((int64_t)a * PHYS_ONE) / b);
+}
+
+static inline phys2_t phys_mul2(phys_t a, phys_t b) { return (int64_t)a * b; }
+
+// Wide value divided by a value
+static inline phys_t phys_div2(phys2_t a, phys_t b)
+{
+    if (b == 0) return a < 0 ? PHYS_MIN : PHYS_MAX;
+    return phys_sat(a / b);
+}
+
+// Square root of a wide value (a >= 0)
+static inline phys_t phys_sqrt2(phys2_t a)
+{
+    uint64_t v = a > 0 ? (uint64_t)a : 0, r = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return phys_sat((int64_t)r);
+}
+
+#else // CONFIG_PHYSICS_FLOAT
+
+typedef float phys_t;
+typedef float phys2_t;
+
+#define PHYS_ONE 1.0f
+#define PHYS_MAX INFINITY
+#define PHYS_MIN (-INFINITY)
+
+#define PHYS(f) ((phys_t)(f))
+
+static inline phys_t phys_from_int(int32_t i) { return (phys_t)i; }
+static inline int32_t phys_floor(phys_t a) { return (int32_t)floorf(a); }
+static inline int32_t phys_ceil(phys_t a) { return (int32_t)ceilf(a); }
+static inline float phys_to_float(phys_t a) { return a; }
+static inline phys_t phys_from_us(int32_t us) { return us * 1.0E-6f; }
+
+static inline phys_t phys_mul(phys_t a, phys_t b) { return a * b; }
+static inline phys_t phys_div(phys_t a, phys_t b) { return a / b; }
+static inline phys2_t phys_mul2(phys_t a, phys_t b) { return a * b; }
+static inline phys_t phys_div2(phys2_t a, phys_t b) { return a / b; }
+static inline phys_t phys_sqrt2(phys2_t a) { return sqrtf(a > 0 ? a : 0); }
+
+#endif // CONFIG_PHYSICS_FLOAT
+
+static inline phys_t phys_min(phys_t a, phys_t b) { return a < b ? a : b; }
+static inline phys_t phys_max(phys_t a, phys_t b) { return a > b ? a : b; }
+static inline phys_t phys_abs(phys_t a) { return a < 0 ? -a : a; }
+static inline phys_t phys_clamp(phys_t a, phys_t lo, phys_t hi)
+{
+    return a < lo ? lo : a > hi ? hi : a;
+}
+
+#endif // PHYS_H_
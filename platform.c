@@ -6,8 +6,10 @@
 #include "lcd.h"
 #include "cursor.h"
 #include "platform.h"
+#include "render.h"
 #include "config.h"
 #include "joy.h"
+#include "input.h"
 
 #define SCREEN_WIDTH LCD_W
 #define SCREEN_HEIGHT LCD_H
@@ -18,24 +20,36 @@ enum platform_st_t {
     active_st
 };
 
+// Move by dt seconds at a joystick displacement, within the screen
+static void move(platform_t *p, int32_t joy_x, phys_t dt) {
+    // Convert to -1 to 1 proportion
+    phys_t joystick_proportion = phys_from_int(joy_x) / JOY_MAX_DISP;
+    
+    // Move platform
+    p->x += phys_mul(phys_mul(joystick_proportion, p->move_speed), dt);
+    
+    // Clamp to screen edges
+    if (p->x < 0) 
+        p->x = 0;
+    if (p->x + p->width > phys_from_int(SCREEN_WIDTH))
+        p->x = phys_from_int(SCREEN_WIDTH) - p->width;
+}
+
 /************************ Initialization *************************/
 void platform_init(platform_t *p, uint32_t move_speed) {
     if (!p) return;
     
-    p->width = 60;  // Platform width
-    p->height = 10; // Platform height
-    p->x = (SCREEN_WIDTH - p->width) / 2;
-    p->y = SCREEN_HEIGHT - p->height - 5;  // 5 pixels from bottom
+    p->width = phys_from_int(60);  // Platform width
+    p->height = phys_from_int(10); // Platform height
+    p->x = (phys_from_int(SCREEN_WIDTH) - p->width) / 2;
+    p->y = phys_from_int(SCREEN_HEIGHT - 5) - p->height;  // 5 pixels from bottom
     p->color = BLUE;
-    p->move_speed = move_speed;
+    p->move_speed = phys_from_int(move_speed);
     p->currentState = init_st;
-    
-    // Initialize joystick if not already done
-    joy_init();
 }
 
 /************************ Control Functions *************************/
-void platform_get_pos(platform_t *p, float *x, float *y, float *w, float *h) {
+void platform_get_pos(platform_t *p, phys_t *x, phys_t *y, phys_t *w, phys_t *h) {
     if (!p) return;
     if (x) *x = p->x;
     if (y) *y = p->y;
@@ -44,11 +58,9 @@ void platform_get_pos(platform_t *p, float *x, float *y, float *w, float *h) {
 }
 
 /************************ Tick Function *************************/
-void platform_tick(platform_t *p) {
+void platform_tick(platform_t *p, phys_t dt) {
     if (!p) return;
     
-    float dt = CONFIG_GAME_TIMER_PERIOD;
-    
     // ---------- State Transitions ----------
     switch (p->currentState) {
         case init_st:
@@ -69,35 +81,29 @@ void platform_tick(platform_t *p) {
             break;
             
         case active_st: {
-            // Erase old position
-            lcd_fillRect((coord_t)p->x, (coord_t)p->y,
-                        (coord_t)p->width, (coord_t)p->height,
-                        CONFIG_COLOR_BACKGROUND);
-            
             // Get joystick input
             int32_t joy_x, joy_y;
-            joy_get_displacement(&joy_x, &joy_y);
-            
-            // Convert to -1 to 1 proportion
-            float joystick_proportion = (float)joy_x / JOY_MAX_DISP;
-            
-            // Move platform
-            p->x += joystick_proportion * p->move_speed * dt;
-            
-            // Clamp to screen edges
-            if (p->x < 0) 
-                p->x = 0;
-            if (p->x + p->width > SCREEN_WIDTH)
-                p->x = SCREEN_WIDTH - p->width;
-            
-            // Draw new position
-            lcd_fillRect((coord_t)p->x, (coord_t)p->y,
-                        (coord_t)p->width, (coord_t)p->height,
-                        p->color);
+            input_get_joy(&joy_x, &joy_y);
+            move(p, joy_x, dt);
             break;
         }
         
         default:
             break;
     }
-}
\ No newline at end of file
+}
+
+void platform_latch(platform_t *p, int32_t joy_x, phys_t dt) {
+    if (!p || p->currentState != active_st) return;
+    move(p, joy_x, dt);
+}
+
+/************************ Draw Function *************************/
+void platform_draw(platform_t *p) {
+    if (!p || p->currentState != active_st) return;
+
+    coord_t x = phys_floor(p->x), y = phys_floor(p->y);
+    coord_t w = phys_floor(p->width), h = phys_floor(p->height);
+    lcd_fillRect(x, y, w, h, p->color);
+    render_add(x, y, w, h);
+}
@@ -4,15 +4,16 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "lcd.h"
+#include "phys.h"
 
 // Platform structure
 typedef struct {
-    float x;                    // Current x position
-    float y;                    // Current y position
-    float width;                // Platform width
-    float height;               // Platform height
+    phys_t x;                   // Current x position
+    phys_t y;                   // Current y position
+    phys_t width;               // Platform width
+    phys_t height;              // Platform height
     color_t color;              // Platform color
-    float move_speed;           // Movement speed
+    phys_t move_speed;          // Movement speed
     uint32_t currentState;      // Current state
 } platform_t;
 
@@ -22,9 +23,20 @@ typedef struct {
 void platform_init(platform_t *p, uint32_t move_speed);
 
 // Control functions
-void platform_get_pos(platform_t *p, float *x, float *y, float *w, float *h);
+void platform_get_pos(platform_t *p, phys_t *x, phys_t *y, phys_t *w, phys_t *h);
 
-// Main tick function
-void platform_tick(platform_t *p);
+// Main tick function, moves the platform by dt seconds
+// (call every physics step)
+void platform_tick(platform_t *p, phys_t dt);
+
+// Move a copy of the platform dt seconds further with a newer joystick
+// displacement, the same way platform_tick() would. This is for drawing
+// only (late latch): the simulation keeps its own platform.
+void platform_latch(platform_t *p, int32_t joy_x, phys_t dt);
+
+// Draw the platform at its current position (call every frame).
+// The drawn box is recorded with the render registry, which erases it
+// at the start of the next frame.
+void platform_draw(platform_t *p);
 
 #endif // PLATFORM_H
\ No newline at end of file
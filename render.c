@@ -0,0 +1,199 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lcd.h"
+#include "render.h"
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+
+#define STALE_WORDS ((RENDER_MAX_KEEP + 31) / 32)
+
+// Retained object
+typedef struct {
+    render_box_t box;
+    uint32_t key;
+    bool shown; // Box holds the drawn object
+} keep_t;
+
+static color_t bg_color;
+static render_box_t boxes[RENDER_MAX_BOXES]; // Transient boxes
+static uint32_t nboxes;
+static bool overflow; // Too many boxes, clear the whole frame
+static keep_t keeps[RENDER_MAX_KEEP];
+static uint32_t stale[STALE_WORDS + 1]; // Bit i: keeps[i] erased since drawn
+static render_box_t dirty[RENDER_MAX_DIRTY]; // Disjoint changed areas
+static uint32_t ndirty;
+
+/************************ Helper Functions *************************/
+static void set_stale(uint32_t i)
+{
+    keeps[i].shown = false;
+    stale[i >> 5] |= 1u << (i & 31);
+}
+
+static void clear_stale(uint32_t i)
+{
+    stale[i >> 5] &= ~(1u << (i & 31));
+}
+
+static bool overlap(const render_box_t *a, const render_box_t *b)
+{
+    return a->x < b->x + b->w && b->x < a->x + a->w &&
+           a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+static int32_t area(const render_box_t *b)
+{
+    return (int32_t)b->w * b->h;
+}
+
+// Grow a to cover b too
+static void join(render_box_t *a, const render_box_t *b)
+{
+    coord_t x1 = MAX(a->x + a->w, b->x + b->w);
+    coord_t y1 = MAX(a->y + a->h, b->y + b->h);
+    a->x = MIN(a->x, b->x);
+    a->y = MIN(a->y, b->y);
+    a->w = x1 - a->x;
+    a->h = y1 - a->y;
+}
+
+// Add a changed area, clipped to the screen. Rectangles it overlaps are
+// merged into it, so the list stays disjoint. When the list is full, it
+// is merged with the rectangle that grows the least.
+static void mark_dirty(const render_box_t *b)
+{
+    coord_t x0 = MAX(b->x, 0), y0 = MAX(b->y, 0);
+    coord_t x1 = MIN(b->x + b->w, LCD_W), y1 = MIN(b->y + b->h, LCD_H);
+    if (x1 <= x0 || y1 <= y0) return; // Off the screen
+    render_box_t u = {x0, y0, x1 - x0, y1 - y0};
+    for (uint32_t i = 0; i < ndirty; ) {
+        if (overlap(&dirty[i], &u)) {
+            join(&u, &dirty[i]);
+            dirty[i] = dirty[--ndirty];
+            i = 0; // The union may overlap one already passed
+        } else {
+            i++;
+        }
+    }
+    if (ndirty == RENDER_MAX_DIRTY) {
+        uint32_t best = 0;
+        int32_t best_grow = INT32_MAX;
+        for (uint32_t i = 0; i < ndirty; i++) {
+            render_box_t j = dirty[i];
+            join(&j, &u);
+            int32_t grow = area(&j) - area(&dirty[i]);
+            if (grow < best_grow) {
+                best_grow = grow;
+                best = i;
+            }
+        }
+        join(&u, &dirty[best]);
+        dirty[best] = dirty[--ndirty];
+        mark_dirty(&u); // Merge whatever the union now overlaps
+        return;
+    }
+    dirty[ndirty++] = u;
+}
+
+// Erase a box and invalidate retained objects under it.
+static void erase(const render_box_t *b)
+{
+    lcd_fillRect(b->x, b->y, b->w, b->h, bg_color);
+    mark_dirty(b);
+    for (uint32_t i = 0; i < RENDER_MAX_KEEP; i++)
+        if (keeps[i].shown && overlap(&keeps[i].box, b))
+            set_stale(i);
+}
+
+/************************ Initialization *************************/
+void render_init(color_t bg)
+{
+    bg_color = bg;
+    nboxes = 0;
+    overflow = true;
+    for (uint32_t i = 0; i < RENDER_MAX_KEEP; i++)
+        keeps[i].shown = false;
+    for (uint32_t w = 0; w <= STALE_WORDS; w++)
+        stale[w] = 0;
+}
+
+void render_reset(void)
+{
+    overflow = true;
+}
+
+/************************ Frame Functions *************************/
+void render_begin(void)
+{
+    ndirty = 0;
+    if (overflow) {
+        render_box_t all = {0, 0, LCD_W, LCD_H};
+        lcd_fillScreen(bg_color);
+        mark_dirty(&all);
+        for (uint32_t i = 0; i < RENDER_MAX_KEEP; i++)
+            if (keeps[i].shown) set_stale(i);
+        overflow = false;
+    } else {
+        for (uint32_t i = 0; i < nboxes; i++)
+            erase(&boxes[i]);
+    }
+    nboxes = 0;
+}
+
+void render_add(coord_t x, coord_t y, coord_t w, coord_t h)
+{
+    if (w <= 0 || h <= 0) return;
+    render_box_t b = {x, y, w, h};
+    mark_dirty(&b);
+    if (nboxes < RENDER_MAX_BOXES) boxes[nboxes++] = b;
+    else overflow = true;
+}
+
+bool render_keep(uint32_t id, coord_t x, coord_t y, coord_t w, coord_t h, uint32_t key)
+{
+    if (id >= RENDER_MAX_KEEP) return true;
+    keep_t *k = &keeps[id];
+    render_box_t b = {x, y, w, h};
+    if (k->shown && k->key == key &&
+        k->box.x == x && k->box.y == y && k->box.w == w && k->box.h == h)
+        return false;
+    if (k->shown) erase(&k->box); // Moved or changed
+    k->box = b;
+    k->key = key;
+    k->shown = true;
+    clear_stale(id);
+    mark_dirty(&b);
+    return true;
+}
+
+void render_drop(uint32_t id)
+{
+    if (id >= RENDER_MAX_KEEP) return;
+    keep_t *k = &keeps[id];
+    clear_stale(id);
+    if (!k->shown) return;
+    k->shown = false;
+    erase(&k->box);
+}
+
+uint32_t render_stale(uint32_t id, uint32_t n)
+{
+    uint32_t all = n >= 32 ? ~0u : (1u << n) - 1;
+    if (id >= RENDER_MAX_KEEP) return all;
+    // Bits id to id+n-1 from two words (the spare last word is zero)
+    uint32_t w = id >> 5, off = id & 31;
+    uint32_t bits = stale[w] >> off;
+    if (off) bits |= stale[w+1] << (32 - off);
+    // Untracked ids past the end
+    if (id + n > RENDER_MAX_KEEP) bits |= all & (~0u << (RENDER_MAX_KEEP - id));
+    return bits & all;
+}
+
+uint32_t render_dirty(render_box_t *boxes)
+{
+    for (uint32_t i = 0; i < ndirty; i++)
+        boxes[i] = dirty[i];
+    return ndirty;
+}
@@ -0,0 +1,77 @@
+#ifndef RENDER_H_
+#define RENDER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lcd.h"
+
+// The render registry replaces clearing the whole frame buffer each frame.
+// Drawable objects record the boxes they draw, and only those boxes are
+// restored to the background at the start of the next frame.
+//
+// Transient objects (ball, platform, text) are redrawn every frame. They
+// call render_add() with the box they draw, and render_begin() erases it
+// before the next frame.
+//
+// Retained objects (bricks) stay on screen until they change. They call
+// render_keep() each frame, which returns true only when they need to be
+// drawn: the first time, after a change of box or key (e.g. color), or
+// after an erased box overlapped them. render_drop() erases a retained
+// object that is gone. Objects that know when they change (bricks) can
+// skip render_keep() while unchanged and ask render_stale() which of
+// them were overlapped by an erase.
+//
+// Everything erased or drawn in a frame is kept as a few disjoint dirty
+// rectangles, each of which can be presented with lcd_writeFrameRect().
+// Overlapping boxes are merged, so e.g. the text at the top and the
+// platform at the bottom are sent as two small rectangles rather than
+// one that covers most of the screen.
+
+#define RENDER_MAX_BOXES 16  // Transient boxes per frame
+#define RENDER_MAX_KEEP  128 // Retained objects (ids 0 to RENDER_MAX_KEEP-1)
+#define RENDER_MAX_DIRTY 4   // Dirty rectangles per frame
+
+// A rectangle on the screen.
+typedef struct {
+    coord_t x, y, w, h;
+} render_box_t;
+
+// Initialize the registry. The next frame starts with a full clear.
+// bg: background color used to erase.
+void render_init(color_t bg);
+
+// Start the next frame with a full clear, and draw every retained object
+// again (e.g. after the frame buffer was drawn over outside the registry).
+void render_reset(void);
+
+// Start a frame: erase the transient boxes of the last frame and
+// invalidate retained objects under them.
+void render_begin(void);
+
+// Record a transient box drawn in this frame.
+void render_add(coord_t x, coord_t y, coord_t w, coord_t h);
+
+// Declare a retained object for this frame.
+// id: object id, 0 to RENDER_MAX_KEEP-1.
+// key: value that changes when the object's appearance changes.
+// Return true if the object must be drawn in its box now.
+bool render_keep(uint32_t id, coord_t x, coord_t y, coord_t w, coord_t h, uint32_t key);
+
+// Erase a retained object that is no longer drawn (once).
+// id: object id.
+void render_drop(uint32_t id);
+
+// Get the retained objects that must be drawn again because an erase
+// (or a full clear) overlapped them since they were drawn.
+// id: first object id; n: number of ids, 1 to 32.
+// Return a mask with bit i set if object id+i is stale. Ids of
+// RENDER_MAX_KEEP and above are not tracked, and are always stale.
+uint32_t render_stale(uint32_t id, uint32_t n);
+
+// Get the areas changed in this frame.
+// boxes: array of RENDER_MAX_DIRTY boxes filled in by the call, disjoint
+// and inside the screen.
+// Return the number of boxes, 0 if nothing changed.
+uint32_t render_dirty(render_box_t *boxes);
+
+#endif // RENDER_H_